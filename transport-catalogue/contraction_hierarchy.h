@@ -0,0 +1,546 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия (contraction hierarchy). Вершины по очереди удаляются из
+// графа в порядке возрастания важности, а кратчайшие пути через удалённую
+// вершину заменяются рёбрами-сокращениями. Запрос - двунаправленный поиск
+// Дейкстры, который идёт только к более важным вершинам
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class ContractionHierarchy {
+public:
+    // Сокращение заменяет путь из двух рёбер first и second. Номера рёбер
+    // сквозные: сначала рёбра исходного графа, затем сокращения
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    struct Data {
+        std::vector<uint32_t> ranks;
+        std::vector<Shortcut> shortcuts;
+    };
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    // Восстанавливает иерархию по ранее посчитанным порядку вершин и сокращениям
+    ContractionHierarchy(const Graph& graph, Data data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Веса кратчайших путей из from во все вершины, бесконечные для недостижимых.
+    // После поиска вверх из from вершины просматриваются по убыванию ранга,
+    // и веса спускаются по рёбрам к менее важным вершинам
+    std::vector<Weight> ComputeWeights(VertexId from) const;
+
+    const Data& GetData() const;
+
+private:
+    struct Arc {
+        VertexId vertex;
+        Weight weight;
+        EdgeId id;
+    };
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = InfiniteWeight<Weight>();
+    // Ограничение поиска свидетелей: если путь в обход вершины не найден за
+    // столько шагов, сокращение добавляется, что не нарушает корректности
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+
+    struct SearchData {
+        std::vector<uint32_t> stamps;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<std::pair<Weight, VertexId>> heap;
+        uint32_t generation = 0;
+
+        void StartSearch(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                stamps.resize(vertex_count, 0);
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+            }
+            if (++generation == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                generation = 1;
+            }
+            heap.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == generation;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            stamps[vertex] = generation;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            heap.emplace_back(weight, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+
+        std::pair<Weight, VertexId> Pop() {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const auto top = heap.back();
+            heap.pop_back();
+            return top;
+        }
+    };
+
+    // Граф, из которого удаляются вершины при построении иерархии
+    struct WorkingGraph {
+        std::vector<std::vector<Arc>> out_arcs;
+        std::vector<std::vector<Arc>> in_arcs;
+        std::vector<bool> contracted;
+        std::vector<size_t> contracted_neighbors;
+        SearchData witness;
+    };
+
+    static SearchData& GetSearchData(bool forward) {
+        static thread_local SearchData forward_data;
+        static thread_local SearchData backward_data;
+        return forward ? forward_data : backward_data;
+    }
+
+    void Contract();
+    void InitSearchGraphs();
+
+    static void AddArc(WorkingGraph& g, VertexId from, VertexId to, Weight weight, EdgeId id);
+    template <typename Callback>
+    static void ForEachShortcut(WorkingGraph& g, VertexId vertex, Callback&& callback);
+    static long long GetPriority(WorkingGraph& g, VertexId vertex);
+
+    std::pair<VertexId, VertexId> GetEdgeEnds(EdgeId edge_id) const;
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    const Graph& graph_;
+    Data data_;
+    // Рёбра к более важным вершинам: для прямого поиска - исходящие,
+    // для обратного - входящие
+    std::vector<size_t> forward_offsets_;
+    std::vector<Arc> forward_arcs_;
+    std::vector<size_t> backward_offsets_;
+    std::vector<Arc> backward_arcs_;
+    // Вершины в порядке убывания ранга
+    std::vector<VertexId> vertices_by_rank_;
+};
+
+template <typename Weight, typename Graph>
+ContractionHierarchy<Weight, Graph>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    Contract();
+    InitSearchGraphs();
+}
+
+template <typename Weight, typename Graph>
+ContractionHierarchy<Weight, Graph>::ContractionHierarchy(const Graph& graph, Data data)
+    : graph_(graph)
+    , data_(std::move(data))
+{
+    if (data_.ranks.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+    }
+    InitSearchGraphs();
+}
+
+template <typename Weight, typename Graph>
+const typename ContractionHierarchy<Weight, Graph>::Data& ContractionHierarchy<Weight, Graph>::GetData() const {
+    return data_;
+}
+
+template <typename Weight, typename Graph>
+void ContractionHierarchy<Weight, Graph>::AddArc(
+    WorkingGraph& g, VertexId from, VertexId to, Weight weight, EdgeId id
+) {
+    // Из параллельных рёбер достаточно хранить самое лёгкое
+    for (Arc& arc : g.out_arcs[from]) {
+        if (arc.vertex != to) {
+            continue;
+        }
+        if (weight < arc.weight) {
+            arc.weight = weight;
+            arc.id = id;
+            for (Arc& in_arc : g.in_arcs[to]) {
+                if (in_arc.vertex == from) {
+                    in_arc.weight = weight;
+                    in_arc.id = id;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+    g.out_arcs[from].push_back({to, weight, id});
+    g.in_arcs[to].push_back({from, weight, id});
+}
+
+// Вызывает callback(from, to, weight, first, second) для каждого сокращения,
+// необходимого при удалении вершины vertex
+template <typename Weight, typename Graph>
+template <typename Callback>
+void ContractionHierarchy<Weight, Graph>::ForEachShortcut(
+    WorkingGraph& g, VertexId vertex, Callback&& callback
+) {
+    for (const Arc& in_arc : g.in_arcs[vertex]) {
+        const VertexId from = in_arc.vertex;
+        if (g.contracted[from] || from == vertex) {
+            continue;
+        }
+
+        Weight max_weight = ZERO_WEIGHT;
+        bool has_targets = false;
+        for (const Arc& out_arc : g.out_arcs[vertex]) {
+            if (!g.contracted[out_arc.vertex] && out_arc.vertex != from && out_arc.vertex != vertex) {
+                max_weight = std::max(max_weight, in_arc.weight + out_arc.weight);
+                has_targets = true;
+            }
+        }
+        if (!has_targets) {
+            continue;
+        }
+
+        // Поиск путей из from в обход vertex не длиннее max_weight
+        SearchData& witness = g.witness;
+        witness.StartSearch(g.out_arcs.size());
+        witness.Reach(from, ZERO_WEIGHT, NO_EDGE);
+        for (size_t settled = 0; !witness.heap.empty() && settled < WITNESS_SETTLE_LIMIT; ++settled) {
+            const auto [weight, current] = witness.Pop();
+            if (witness.weights[current] < weight) {
+                continue;
+            }
+            if (max_weight < weight) {
+                break;
+            }
+            for (const Arc& arc : g.out_arcs[current]) {
+                if (g.contracted[arc.vertex] || arc.vertex == vertex) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + arc.weight;
+                if (!witness.IsReached(arc.vertex) || candidate_weight < witness.weights[arc.vertex]) {
+                    witness.Reach(arc.vertex, candidate_weight, arc.id);
+                }
+            }
+        }
+
+        for (const Arc& out_arc : g.out_arcs[vertex]) {
+            const VertexId to = out_arc.vertex;
+            if (g.contracted[to] || to == from || to == vertex) {
+                continue;
+            }
+            const Weight weight = in_arc.weight + out_arc.weight;
+            if (!witness.IsReached(to) || weight < witness.weights[to]) {
+                callback(from, to, weight, in_arc.id, out_arc.id);
+            }
+        }
+    }
+}
+
+// Разность числа добавляемых сокращений и удаляемых рёбер плюс число уже
+// удалённых соседей, чтобы вершины удалялись равномерно по графу
+template <typename Weight, typename Graph>
+long long ContractionHierarchy<Weight, Graph>::GetPriority(WorkingGraph& g, VertexId vertex) {
+    long long shortcuts = 0;
+    ForEachShortcut(g, vertex, [&shortcuts](VertexId, VertexId, Weight, EdgeId, EdgeId) {
+        ++shortcuts;
+    });
+
+    long long removed_arcs = 0;
+    for (const Arc& arc : g.in_arcs[vertex]) {
+        removed_arcs += g.contracted[arc.vertex] ? 0 : 1;
+    }
+    for (const Arc& arc : g.out_arcs[vertex]) {
+        removed_arcs += g.contracted[arc.vertex] ? 0 : 1;
+    }
+
+    return shortcuts - removed_arcs + static_cast<long long>(g.contracted_neighbors[vertex]);
+}
+
+template <typename Weight, typename Graph>
+void ContractionHierarchy<Weight, Graph>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const EdgeId edge_count = graph_.GetEdgeCount();
+
+    WorkingGraph g;
+    g.out_arcs.resize(vertex_count);
+    g.in_arcs.resize(vertex_count);
+    g.contracted.assign(vertex_count, false);
+    g.contracted_neighbors.assign(vertex_count, 0);
+
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.from != edge.to && edge.weight != INFINITE_WEIGHT) {
+            AddArc(g, edge.from, edge.to, edge.weight, edge_id);
+        }
+    }
+
+    using QueueItem = std::pair<long long, VertexId>;
+    std::vector<QueueItem> queue;
+    queue.reserve(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.emplace_back(GetPriority(g, vertex), vertex);
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<>{});
+
+    data_.ranks.assign(vertex_count, 0);
+    uint32_t rank = 0;
+    std::vector<Shortcut> shortcuts;
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+        const VertexId vertex = queue.back().second;
+        queue.pop_back();
+
+        // Приоритеты пересчитываются лениво: если вершина стала менее
+        // выгодной, чем следующая в очереди, она возвращается в очередь
+        const long long priority = GetPriority(g, vertex);
+        if (!queue.empty() && queue.front().first < priority) {
+            queue.emplace_back(priority, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+            continue;
+        }
+
+        shortcuts.clear();
+        ForEachShortcut(g, vertex, [&shortcuts](
+            VertexId from, VertexId to, Weight weight, EdgeId first, EdgeId second
+        ) {
+            shortcuts.push_back({from, to, weight, first, second});
+        });
+        for (const Shortcut& shortcut : shortcuts) {
+            const EdgeId id = edge_count + data_.shortcuts.size();
+            data_.shortcuts.push_back(shortcut);
+            AddArc(g, shortcut.from, shortcut.to, shortcut.weight, id);
+        }
+
+        g.contracted[vertex] = true;
+        data_.ranks[vertex] = rank++;
+        for (const Arc& arc : g.in_arcs[vertex]) {
+            ++g.contracted_neighbors[arc.vertex];
+        }
+        for (const Arc& arc : g.out_arcs[vertex]) {
+            ++g.contracted_neighbors[arc.vertex];
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+void ContractionHierarchy<Weight, Graph>::InitSearchGraphs() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const EdgeId edge_count = graph_.GetEdgeCount();
+    const EdgeId total_count = edge_count + data_.shortcuts.size();
+
+    auto get_arc = [this, edge_count](EdgeId id) {
+        if (id < edge_count) {
+            const auto& edge = graph_.GetEdge(id);
+            return Shortcut{edge.from, edge.to, edge.weight, NO_EDGE, NO_EDGE};
+        }
+        return data_.shortcuts[id - edge_count];
+    };
+
+    vertices_by_rank_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        vertices_by_rank_[vertex_count - 1 - data_.ranks[vertex]] = vertex;
+    }
+
+    forward_offsets_.assign(vertex_count + 1, 0);
+    backward_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId id = 0; id < total_count; ++id) {
+        const Shortcut arc = get_arc(id);
+        if (arc.from == arc.to || arc.weight == INFINITE_WEIGHT) {
+            continue;
+        }
+        if (data_.ranks[arc.from] < data_.ranks[arc.to]) {
+            ++forward_offsets_[arc.from + 1];
+        } else {
+            ++backward_offsets_[arc.to + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        forward_offsets_[vertex + 1] += forward_offsets_[vertex];
+        backward_offsets_[vertex + 1] += backward_offsets_[vertex];
+    }
+
+    forward_arcs_.resize(forward_offsets_[vertex_count]);
+    backward_arcs_.resize(backward_offsets_[vertex_count]);
+    std::vector<size_t> forward_pos(forward_offsets_.begin(), forward_offsets_.end() - 1);
+    std::vector<size_t> backward_pos(backward_offsets_.begin(), backward_offsets_.end() - 1);
+    for (EdgeId id = 0; id < total_count; ++id) {
+        const Shortcut arc = get_arc(id);
+        if (arc.from == arc.to || arc.weight == INFINITE_WEIGHT) {
+            continue;
+        }
+        if (data_.ranks[arc.from] < data_.ranks[arc.to]) {
+            forward_arcs_[forward_pos[arc.from]++] = {arc.to, arc.weight, id};
+        } else {
+            backward_arcs_[backward_pos[arc.to]++] = {arc.from, arc.weight, id};
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+std::pair<VertexId, VertexId> ContractionHierarchy<Weight, Graph>::GetEdgeEnds(EdgeId edge_id) const {
+    if (edge_id < graph_.GetEdgeCount()) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        return {edge.from, edge.to};
+    }
+    const Shortcut& shortcut = data_.shortcuts[edge_id - graph_.GetEdgeCount()];
+    return {shortcut.from, shortcut.to};
+}
+
+// Раскрывает ребро в последовательность рёбер исходного графа
+template <typename Weight, typename Graph>
+void ContractionHierarchy<Weight, Graph>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const EdgeId id = stack.back();
+        stack.pop_back();
+        if (id < graph_.GetEdgeCount()) {
+            edges.push_back(id);
+        } else {
+            const Shortcut& shortcut = data_.shortcuts[id - graph_.GetEdgeCount()];
+            stack.push_back(shortcut.second);
+            stack.push_back(shortcut.first);
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename ContractionHierarchy<Weight, Graph>::RouteInfo>
+ContractionHierarchy<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    SearchData& forward = GetSearchData(true);
+    SearchData& backward = GetSearchData(false);
+    forward.StartSearch(vertex_count);
+    backward.StartSearch(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+
+    Weight best_weight = INFINITE_WEIGHT;
+    VertexId meeting_vertex = vertex_count;
+
+    auto top_weight = [](const SearchData& data) {
+        return data.heap.empty() ? INFINITE_WEIGHT : data.heap.front().first;
+    };
+
+    while (std::min(top_weight(forward), top_weight(backward)) < best_weight) {
+        const bool is_forward = top_weight(forward) <= top_weight(backward);
+        SearchData& current = is_forward ? forward : backward;
+        const SearchData& other = is_forward ? backward : forward;
+
+        const auto [weight, vertex] = current.Pop();
+        if (current.weights[vertex] < weight) {
+            continue;
+        }
+        if (other.IsReached(vertex) && weight + other.weights[vertex] < best_weight) {
+            best_weight = weight + other.weights[vertex];
+            meeting_vertex = vertex;
+        }
+
+        const auto& offsets = is_forward ? forward_offsets_ : backward_offsets_;
+        const auto& arcs = is_forward ? forward_arcs_ : backward_arcs_;
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const Arc& arc = arcs[i];
+            const Weight candidate_weight = weight + arc.weight;
+            if (!current.IsReached(arc.vertex) || candidate_weight < current.weights[arc.vertex]) {
+                current.Reach(arc.vertex, candidate_weight, arc.id);
+            }
+        }
+    }
+
+    if (meeting_vertex == vertex_count) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> up_edges;
+    for (EdgeId edge_id = forward.prev_edges[meeting_vertex];
+         edge_id != NO_EDGE;
+         edge_id = forward.prev_edges[GetEdgeEnds(edge_id).first])
+    {
+        up_edges.push_back(edge_id);
+    }
+    std::reverse(up_edges.begin(), up_edges.end());
+    for (EdgeId edge_id = backward.prev_edges[meeting_vertex];
+         edge_id != NO_EDGE;
+         edge_id = backward.prev_edges[GetEdgeEnds(edge_id).second])
+    {
+        up_edges.push_back(edge_id);
+    }
+
+    RouteInfo result{best_weight, {}};
+    for (const EdgeId edge_id : up_edges) {
+        UnpackEdge(edge_id, result.edges);
+    }
+    return result;
+}
+
+template <typename Weight, typename Graph>
+std::vector<Weight> ContractionHierarchy<Weight, Graph>::ComputeWeights(VertexId from) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<Weight> weights(vertex_count, INFINITE_WEIGHT);
+
+    SearchData& forward = GetSearchData(true);
+    forward.StartSearch(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    while (!forward.heap.empty()) {
+        const auto [weight, vertex] = forward.Pop();
+        if (forward.weights[vertex] < weight) {
+            continue;
+        }
+        weights[vertex] = weight;
+        for (size_t i = forward_offsets_[vertex]; i < forward_offsets_[vertex + 1]; ++i) {
+            const Arc& arc = forward_arcs_[i];
+            const Weight candidate_weight = weight + arc.weight;
+            if (!forward.IsReached(arc.vertex) || candidate_weight < forward.weights[arc.vertex]) {
+                forward.Reach(arc.vertex, candidate_weight, arc.id);
+            }
+        }
+    }
+
+    for (const VertexId vertex : vertices_by_rank_) {
+        for (size_t i = backward_offsets_[vertex]; i < backward_offsets_[vertex + 1]; ++i) {
+            const Arc& arc = backward_arcs_[i];
+            if (weights[arc.vertex] != INFINITE_WEIGHT) {
+                weights[vertex] = std::min(weights[vertex], weights[arc.vertex] + arc.weight);
+            }
+        }
+    }
+
+    return weights;
+}
+
+}  // namespace graph
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class DijkstraRouter {
+public:
+    explicit DijkstraRouter(const Graph& graph);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Поиск A*: heuristic(vertex) - нижняя оценка веса пути от vertex до to.
+    // Если оценка не завышает веса, найденный маршрут кратчайший
+    template <typename Heuristic>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, Heuristic&& heuristic) const;
+
+    // Веса кратчайших путей из from во все вершины, бесконечные для недостижимых
+    std::vector<Weight> ComputeWeights(VertexId from) const;
+    // Вершины, достижимые из from с весом не больше max_weight, с весами путей
+    // в порядке их неубывания. Поиск не выходит за пределы этой области
+    std::vector<std::pair<VertexId, Weight>> ComputeReachable(VertexId from, Weight max_weight) const;
+
+private:
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight ZERO_WEIGHT{};
+    // Вес удалённых рёбер, такие рёбра пропускаются
+    static constexpr Weight INFINITE_WEIGHT = InfiniteWeight<Weight>();
+
+    // Буферы поиска общие для всех запросов одного потока. Данные вершины
+    // действительны, только если её метка совпадает с текущим поколением,
+    // поэтому перед новым поиском буферы не нужно обнулять
+    struct SearchData {
+        std::vector<uint32_t> stamps;
+        std::vector<Weight> weights;
+        // Оценка эвристики считается один раз, когда вершина впервые достигнута
+        std::vector<Weight> bounds;
+        std::vector<EdgeId> prev_edges;
+        // Пары (вес плюс оценка, вершина)
+        std::vector<std::pair<Weight, VertexId>> heap;
+        uint32_t generation = 0;
+
+        void StartSearch(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                stamps.resize(vertex_count, 0);
+                weights.resize(vertex_count);
+                bounds.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+            }
+            if (++generation == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                generation = 1;
+            }
+            heap.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == generation;
+        }
+
+        void Reach(VertexId vertex, Weight weight, Weight bound, EdgeId prev_edge) {
+            stamps[vertex] = generation;
+            weights[vertex] = weight;
+            bounds[vertex] = bound;
+            prev_edges[vertex] = prev_edge;
+            heap.emplace_back(weight + bound, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+    };
+
+    static SearchData& GetSearchData() {
+        static thread_local SearchData data;
+        return data;
+    }
+
+    const Graph& graph_;
+};
+
+template <typename Weight, typename Graph>
+DijkstraRouter<Weight, Graph>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename DijkstraRouter<Weight, Graph>::RouteInfo> DijkstraRouter<Weight, Graph>::BuildRoute(
+    VertexId from, VertexId to
+) const {
+    return BuildRoute(from, to, [](VertexId) {
+        return ZERO_WEIGHT;
+    });
+}
+
+template <typename Weight, typename Graph>
+template <typename Heuristic>
+std::optional<typename DijkstraRouter<Weight, Graph>::RouteInfo> DijkstraRouter<Weight, Graph>::BuildRoute(
+    VertexId from, VertexId to, Heuristic&& heuristic
+) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetSearchData();
+    data.StartSearch(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, heuristic(from), NO_EDGE);
+
+    while (!data.heap.empty()) {
+        std::pop_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+        const auto [estimate, vertex] = data.heap.back();
+        data.heap.pop_back();
+
+        if (data.weights[vertex] + data.bounds[vertex] < estimate) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+
+        const Weight weight = data.weights[vertex];
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight == INFINITE_WEIGHT) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            if (!data.IsReached(edge.to)) {
+                data.Reach(edge.to, candidate_weight, heuristic(edge.to), edge_id);
+            } else if (candidate_weight < data.weights[edge.to]) {
+                data.Reach(edge.to, candidate_weight, data.bounds[edge.to], edge_id);
+            }
+        }
+    }
+
+    if (!data.IsReached(to)) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = data.prev_edges[to];
+         edge_id != NO_EDGE;
+         edge_id = data.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{data.weights[to], std::move(edges)};
+}
+
+template <typename Weight, typename Graph>
+std::vector<Weight> DijkstraRouter<Weight, Graph>::ComputeWeights(VertexId from) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetSearchData();
+    data.StartSearch(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, NO_EDGE);
+
+    std::vector<Weight> weights(vertex_count, INFINITE_WEIGHT);
+    while (!data.heap.empty()) {
+        std::pop_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+        const auto [weight, vertex] = data.heap.back();
+        data.heap.pop_back();
+
+        if (data.weights[vertex] < weight) {
+            continue;
+        }
+        weights[vertex] = weight;
+
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight == INFINITE_WEIGHT) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            if (!data.IsReached(edge.to) || candidate_weight < data.weights[edge.to]) {
+                data.Reach(edge.to, candidate_weight, ZERO_WEIGHT, edge_id);
+            }
+        }
+    }
+
+    return weights;
+}
+
+template <typename Weight, typename Graph>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight, Graph>::ComputeReachable(
+    VertexId from, Weight max_weight
+) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchData& data = GetSearchData();
+    data.StartSearch(vertex_count);
+    data.Reach(from, ZERO_WEIGHT, ZERO_WEIGHT, NO_EDGE);
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    while (!data.heap.empty()) {
+        std::pop_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+        const auto [weight, vertex] = data.heap.back();
+        data.heap.pop_back();
+
+        if (data.weights[vertex] < weight) {
+            continue;
+        }
+        reachable.emplace_back(vertex, weight);
+
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight == INFINITE_WEIGHT) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!data.IsReached(edge.to) || candidate_weight < data.weights[edge.to]) {
+                data.Reach(edge.to, candidate_weight, ZERO_WEIGHT, edge_id);
+            }
+        }
+    }
+
+    return reachable;
+}
+
+}  // namespace graph
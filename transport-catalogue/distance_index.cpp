@@ -0,0 +1,94 @@
+#include "distance_index.h"
+
+#include <algorithm>
+
+namespace catalogue {
+
+void DistanceIndex::Set(domain::StopId from, domain::StopId to, double distance) {
+    // Заполненность таблицы не больше 3/4
+    if ((size_ + 1) * 4 > keys_.size() * 3) {
+        Grow();
+    }
+    const uint64_t key = MakeKey(from, to);
+    const size_t slot = FindSlot(key);
+    if (keys_[slot] == EMPTY_KEY) {
+        keys_[slot] = key;
+        ++size_;
+    }
+    distances_[slot] = distance;
+}
+
+const double* DistanceIndex::Find(domain::StopId from, domain::StopId to) const {
+    if (size_ == 0) {
+        return nullptr;
+    }
+    const size_t slot = FindSlot(MakeKey(from, to));
+    return keys_[slot] == EMPTY_KEY ? nullptr : &distances_[slot];
+}
+
+std::optional<double> DistanceIndex::Get(domain::StopId from, domain::StopId to) const {
+    if (const double* distance = Find(from, to)) {
+        return *distance;
+    }
+    if (const double* distance = Find(to, from)) {
+        return *distance;
+    }
+    return std::nullopt;
+}
+
+size_t DistanceIndex::GetSize() const {
+    return size_;
+}
+
+std::vector<std::tuple<domain::StopId, domain::StopId, double>> DistanceIndex::GetEntries() const {
+    std::vector<std::tuple<domain::StopId, domain::StopId, double>> entries;
+    entries.reserve(size_);
+    for (size_t slot = 0; slot < keys_.size(); ++slot) {
+        if (keys_[slot] != EMPTY_KEY) {
+            entries.emplace_back(
+                static_cast<domain::StopId>(keys_[slot] >> 32),
+                static_cast<domain::StopId>(keys_[slot]),
+                distances_[slot]
+            );
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+uint64_t DistanceIndex::MakeKey(domain::StopId from, domain::StopId to) {
+    return (uint64_t{from} << 32) | to;
+}
+
+// Слот с ключом key либо пустой слот, в который его нужно записать
+size_t DistanceIndex::FindSlot(uint64_t key) const {
+    const size_t mask = keys_.size() - 1;
+    size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+    while (keys_[slot] != key && keys_[slot] != EMPTY_KEY) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void DistanceIndex::Grow() {
+    std::vector<uint64_t> keys = std::move(keys_);
+    std::vector<double> distances = std::move(distances_);
+
+    const size_t capacity = std::max(keys.size() * 2, MIN_CAPACITY);
+    keys_.assign(capacity, EMPTY_KEY);
+    distances_.assign(capacity, 0);
+    shift_ = 64;
+    for (size_t size = capacity; size > 1; size /= 2) {
+        --shift_;
+    }
+
+    for (size_t slot = 0; slot < keys.size(); ++slot) {
+        if (keys[slot] != EMPTY_KEY) {
+            const size_t new_slot = FindSlot(keys[slot]);
+            keys_[new_slot] = keys[slot];
+            distances_[new_slot] = distances[slot];
+        }
+    }
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace catalogue {
+
+// Расстояния между парами остановок в хеш-таблице с открытой адресацией.
+// Пара номеров упаковывается в 64-битный ключ, ключи и расстояния лежат
+// в двух массивах, поэтому запись занимает 16 байт без отдельных выделений
+// памяти. Коллизии разрешаются линейным пробированием
+class DistanceIndex {
+public:
+    void Set(domain::StopId from, domain::StopId to, double distance);
+
+    // Расстояние from -> to, заданное именно в этом направлении
+    const double* Find(domain::StopId from, domain::StopId to) const;
+    // Расстояние from -> to, а если оно не задано - to -> from
+    std::optional<double> Get(domain::StopId from, domain::StopId to) const;
+
+    size_t GetSize() const;
+    // Все записи (from, to, расстояние) в порядке номеров остановок
+    std::vector<std::tuple<domain::StopId, domain::StopId, double>> GetEntries() const;
+
+private:
+    static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    static uint64_t MakeKey(domain::StopId from, domain::StopId to);
+    size_t FindSlot(uint64_t key) const;
+    void Grow();
+
+    std::vector<uint64_t> keys_;
+    std::vector<double> distances_;
+    size_t size_ = 0;
+    // Номер слота - старшие биты произведения ключа на нечётную константу
+    unsigned shift_ = 64;
+};
+
+}
@@ -1,24 +1,53 @@
 #pragma once
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "geo.h"
 
 namespace catalogue::domain {
 
+// Номера остановок и автобусов в справочнике, идут подряд с нуля
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Имена указывают в хранилище имён справочника или того, кто их прочитал
 struct Stop {
-    std::string name;
+    std::string_view name;
     geo::Coordinates coords;
+    StopId id = 0;
 };
 
 struct Bus {
-    std::string name;
-    std::vector<const Stop*> stops;
+    std::string_view name;
+    std::vector<StopId> stops;
     bool is_roundtrip;
+    BusId id = 0;
+};
+
+enum class RouterType {
+    ALL_PAIRS,
+    DIJKSTRA,
+    RAPTOR,
+    CONTRACTION_HIERARCHY,
+    A_STAR,
+    HUB_LABELS,
+};
+
+// Модель графа маршрутов: у остановки вершины прибытия и посадки, соединённые
+// ребром ожидания, или одна вершина, а ожидание входит в вес рёбер поездок
+enum class GraphModel {
+    WAIT_EDGES,
+    SINGLE_VERTEX,
 };
 
 struct RoutingSettings {
     int bus_wait_time;
     double bus_velocity;
+    RouterType router_type = RouterType::ALL_PAIRS;
+    GraphModel graph_model = GraphModel::WAIT_EDGES;
+    // Число потоков построения маршрутизатора, 0 - по числу ядер
+    size_t thread_count = 0;
 };
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <limits>
 #include <vector>
 
 namespace graph {
@@ -10,6 +11,16 @@ namespace graph {
 using VertexId = size_t;
 using EdgeId = size_t;
 
+// Вес, которым обозначается отсутствие пути
+template <typename Weight>
+constexpr Weight InfiniteWeight() {
+    if constexpr (std::numeric_limits<Weight>::has_infinity) {
+        return std::numeric_limits<Weight>::infinity();
+    } else {
+        return std::numeric_limits<Weight>::max();
+    }
+}
+
 template <typename Weight>
 struct Edge {
     VertexId from;
@@ -27,6 +38,9 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    VertexId AddVertex();
+    // Удалённое ребро получает бесконечный вес, его номер остаётся занятым
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -51,6 +65,17 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -71,4 +96,70 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+// Неизменяемое представление графа в формате CSR: номера рёбер, исходящих из
+// вершины, лежат подряд в общем массиве, а границы списков задаются массивом
+// смещений. Номера рёбер совпадают с номерами в исходном графе
+template <typename Weight>
+class CsrGraph {
+private:
+    using IncidentEdgesRange = ranges::Range<typename std::vector<EdgeId>::const_iterator>;
+
+public:
+    CsrGraph() = default;
+    explicit CsrGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const;
+    size_t GetEdgeCount() const;
+    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+
+private:
+    std::vector<Edge<Weight>> edges_;
+    std::vector<size_t> offsets_;
+    std::vector<EdgeId> incident_edges_;
+};
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight>& graph)
+    : offsets_(graph.GetVertexCount() + 1, 0)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    edges_.reserve(graph.GetEdgeCount());
+    incident_edges_.reserve(graph.GetEdgeCount());
+
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        edges_.push_back(graph.GetEdge(edge_id));
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            incident_edges_.push_back(edge_id);
+        }
+        offsets_[vertex + 1] = incident_edges_.size();
+    }
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetVertexCount() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t CsrGraph<Weight>::GetEdgeCount() const {
+    return edges_.size();
+}
+
+template <typename Weight>
+const Edge<Weight>& CsrGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    return edges_[edge_id];
+}
+
+template <typename Weight>
+typename CsrGraph<Weight>::IncidentEdgesRange CsrGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+    return IncidentEdgesRange(
+        incident_edges_.begin() + offsets_[vertex],
+        incident_edges_.begin() + offsets_[vertex + 1]
+    );
+}
+
 }  // namespace graph
\ No newline at end of file
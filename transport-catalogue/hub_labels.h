@@ -0,0 +1,374 @@
+#pragma once
+
+#include "contraction_hierarchy.h"
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Метки хабов (2-hop labeling). Каждой вершине v сопоставляются прямая метка -
+// хабы h с весами путей v -> h, и обратная - хабы с весами путей h -> v.
+// Для любой пары вершин общий хаб их меток лежит на кратчайшем пути, поэтому
+// запрос - слияние двух коротких отсортированных массивов
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class HubLabels {
+public:
+    // Записи метки вершины v лежат в диапазоне [offsets[v], offsets[v + 1])
+    // по возрастанию номера хаба. edges - первое ребро пути к хабу в прямых
+    // метках и последнее ребро пути от хаба в обратных, NO_EDGE у самого хаба
+    struct LabelSet {
+        std::vector<size_t> offsets;
+        std::vector<uint32_t> hubs;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> edges;
+    };
+
+    struct Data {
+        LabelSet forward;
+        LabelSet backward;
+    };
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    explicit HubLabels(const Graph& graph);
+    // Восстанавливает ранее посчитанные метки
+    HubLabels(const Graph& graph, Data data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Веса кратчайших путей из from во все вершины, бесконечные для недостижимых
+    std::vector<Weight> ComputeWeights(VertexId from) const;
+
+    const Data& GetData() const;
+
+private:
+    struct Entry {
+        uint32_t hub;
+        Weight weight;
+        EdgeId edge;
+    };
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = InfiniteWeight<Weight>();
+
+    // Вершины обходятся в порядке убывания ранга иерархии сжатия: важные
+    // вершины покрывают много путей, и поиски из остальных быстро отсекаются
+    void Build();
+    static LabelSet Flatten(const std::vector<std::vector<Entry>>& labels);
+
+    // Номер хаба с наименьшим весом пути from -> hub -> to
+    std::optional<std::pair<Weight, uint32_t>> FindHub(VertexId from, VertexId to) const;
+    static EdgeId FindEdge(const LabelSet& labels, VertexId vertex, uint32_t hub);
+
+    const Graph& graph_;
+    Data data_;
+};
+
+template <typename Weight, typename Graph>
+HubLabels<Weight, Graph>::HubLabels(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    Build();
+}
+
+template <typename Weight, typename Graph>
+HubLabels<Weight, Graph>::HubLabels(const Graph& graph, Data data)
+    : graph_(graph)
+    , data_(std::move(data))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    for (const LabelSet* labels : {&data_.forward, &data_.backward}) {
+        if (labels->offsets.size() != vertex_count + 1
+            || labels->offsets.back() != labels->hubs.size()
+            || labels->hubs.size() != labels->weights.size()
+            || labels->hubs.size() != labels->edges.size()) {
+            throw std::invalid_argument("Hub labels don't match the graph");
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+const typename HubLabels<Weight, Graph>::Data& HubLabels<Weight, Graph>::GetData() const {
+    return data_;
+}
+
+template <typename Weight, typename Graph>
+void HubLabels<Weight, Graph>::Build() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const EdgeId edge_count = graph_.GetEdgeCount();
+
+    std::vector<VertexId> order(vertex_count);
+    {
+        const std::vector<uint32_t> ranks = ContractionHierarchy<Weight, Graph>(graph_).GetData().ranks;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            order[vertex_count - 1 - ranks[vertex]] = vertex;
+        }
+    }
+
+    // Входящие рёбра для поисков к хабу
+    std::vector<size_t> in_offsets(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        ++in_offsets[graph_.GetEdge(edge_id).to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        in_offsets[vertex + 1] += in_offsets[vertex];
+    }
+    std::vector<EdgeId> in_edges(edge_count);
+    {
+        std::vector<size_t> pos(in_offsets.begin(), in_offsets.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            in_edges[pos[graph_.GetEdge(edge_id).to]++] = edge_id;
+        }
+    }
+
+    std::vector<std::vector<Entry>> forward(vertex_count);
+    std::vector<std::vector<Entry>> backward(vertex_count);
+
+    std::vector<Weight> weights(vertex_count, INFINITE_WEIGHT);
+    std::vector<EdgeId> prev_edges(vertex_count, NO_EDGE);
+    std::vector<VertexId> reached;
+    std::vector<std::pair<Weight, VertexId>> heap;
+    // hub_weights[h] - вес пути между текущим хабом и хабом h из его метки
+    std::vector<Weight> hub_weights(vertex_count, INFINITE_WEIGHT);
+
+    // Дейкстра из хаба с отсечением: если уже построенные метки дают путь
+    // не длиннее найденного, вершина не получает запись и не раскрывается.
+    // Поэтому у предыдущей вершины каждого пути к записи хаб тоже есть
+    auto pruned_search = [&](VertexId root, uint32_t hub, bool is_forward) {
+        const auto& root_label = is_forward ? forward[root] : backward[root];
+        auto& labels = is_forward ? backward : forward;
+        for (const Entry& entry : root_label) {
+            hub_weights[entry.hub] = entry.weight;
+        }
+
+        weights[root] = ZERO_WEIGHT;
+        reached.push_back(root);
+        heap.emplace_back(ZERO_WEIGHT, root);
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            const Weight weight = heap.back().first;
+            const VertexId vertex = heap.back().second;
+            heap.pop_back();
+            if (weights[vertex] < weight) {
+                continue;
+            }
+
+            Weight covered = INFINITE_WEIGHT;
+            for (const Entry& entry : labels[vertex]) {
+                if (hub_weights[entry.hub] != INFINITE_WEIGHT) {
+                    covered = std::min(covered, hub_weights[entry.hub] + entry.weight);
+                }
+            }
+            if (covered <= weight) {
+                continue;
+            }
+            labels[vertex].push_back({hub, weight, prev_edges[vertex]});
+
+            auto relax = [&](EdgeId edge_id, VertexId next) {
+                const Weight edge_weight = graph_.GetEdge(edge_id).weight;
+                if (edge_weight == INFINITE_WEIGHT) {
+                    return;
+                }
+                const Weight candidate_weight = weight + edge_weight;
+                if (candidate_weight < weights[next]) {
+                    if (weights[next] == INFINITE_WEIGHT) {
+                        reached.push_back(next);
+                    }
+                    weights[next] = candidate_weight;
+                    prev_edges[next] = edge_id;
+                    heap.emplace_back(candidate_weight, next);
+                    std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+                }
+            };
+            if (is_forward) {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).to);
+                }
+            } else {
+                for (size_t i = in_offsets[vertex]; i < in_offsets[vertex + 1]; ++i) {
+                    relax(in_edges[i], graph_.GetEdge(in_edges[i]).from);
+                }
+            }
+        }
+
+        for (const VertexId vertex : reached) {
+            weights[vertex] = INFINITE_WEIGHT;
+            prev_edges[vertex] = NO_EDGE;
+        }
+        reached.clear();
+        for (const Entry& entry : root_label) {
+            hub_weights[entry.hub] = INFINITE_WEIGHT;
+        }
+    };
+
+    for (uint32_t hub = 0; hub < vertex_count; ++hub) {
+        // Прямой поиск дополняет обратные метки, обратный - прямые
+        pruned_search(order[hub], hub, true);
+        pruned_search(order[hub], hub, false);
+    }
+
+    data_.forward = Flatten(forward);
+    data_.backward = Flatten(backward);
+}
+
+template <typename Weight, typename Graph>
+typename HubLabels<Weight, Graph>::LabelSet HubLabels<Weight, Graph>::Flatten(
+    const std::vector<std::vector<Entry>>& labels
+) {
+    LabelSet result;
+    result.offsets.reserve(labels.size() + 1);
+    result.offsets.push_back(0);
+    for (const auto& label : labels) {
+        result.offsets.push_back(result.offsets.back() + label.size());
+    }
+    result.hubs.reserve(result.offsets.back());
+    result.weights.reserve(result.offsets.back());
+    result.edges.reserve(result.offsets.back());
+    for (const auto& label : labels) {
+        for (const Entry& entry : label) {
+            result.hubs.push_back(entry.hub);
+            result.weights.push_back(entry.weight);
+            result.edges.push_back(entry.edge);
+        }
+    }
+    return result;
+}
+
+template <typename Weight, typename Graph>
+std::optional<std::pair<Weight, uint32_t>> HubLabels<Weight, Graph>::FindHub(
+    VertexId from, VertexId to
+) const {
+    const LabelSet& forward = data_.forward;
+    const LabelSet& backward = data_.backward;
+
+    size_t i = forward.offsets[from];
+    const size_t i_end = forward.offsets[from + 1];
+    size_t j = backward.offsets[to];
+    const size_t j_end = backward.offsets[to + 1];
+
+    Weight best_weight = INFINITE_WEIGHT;
+    uint32_t best_hub = 0;
+    while (i < i_end && j < j_end) {
+        const uint32_t lhs = forward.hubs[i];
+        const uint32_t rhs = backward.hubs[j];
+        if (lhs == rhs) {
+            const Weight weight = forward.weights[i] + backward.weights[j];
+            if (weight < best_weight) {
+                best_weight = weight;
+                best_hub = lhs;
+            }
+            ++i;
+            ++j;
+        } else if (lhs < rhs) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+
+    if (best_weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    return std::pair{best_weight, best_hub};
+}
+
+template <typename Weight, typename Graph>
+EdgeId HubLabels<Weight, Graph>::FindEdge(const LabelSet& labels, VertexId vertex, uint32_t hub) {
+    const auto begin = labels.hubs.begin() + labels.offsets[vertex];
+    const auto end = labels.hubs.begin() + labels.offsets[vertex + 1];
+    const auto it = std::lower_bound(begin, end, hub);
+    if (it == end || *it != hub) {
+        throw std::logic_error("Hub labels are inconsistent");
+    }
+    return labels.edges[it - labels.hubs.begin()];
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename HubLabels<Weight, Graph>::RouteInfo>
+HubLabels<Weight, Graph>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    const auto hub = FindHub(from, to);
+    if (!hub) {
+        return std::nullopt;
+    }
+
+    // Путь к хабу восстанавливается по прямым меткам вершин пути,
+    // путь от хаба - по обратным, начиная с конца
+    RouteInfo result{hub->first, {}};
+    for (VertexId vertex = from;;) {
+        const EdgeId edge_id = FindEdge(data_.forward, vertex, hub->second);
+        if (edge_id == NO_EDGE) {
+            break;
+        }
+        result.edges.push_back(edge_id);
+        vertex = graph_.GetEdge(edge_id).to;
+    }
+    const size_t up_size = result.edges.size();
+    for (VertexId vertex = to;;) {
+        const EdgeId edge_id = FindEdge(data_.backward, vertex, hub->second);
+        if (edge_id == NO_EDGE) {
+            break;
+        }
+        result.edges.push_back(edge_id);
+        vertex = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(result.edges.begin() + up_size, result.edges.end());
+
+    return result;
+}
+
+template <typename Weight, typename Graph>
+std::vector<Weight> HubLabels<Weight, Graph>::ComputeWeights(VertexId from) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    // Метка from раскладывается по номерам хабов, и каждая обратная метка
+    // просматривается один раз без слияния
+    std::vector<Weight> hub_weights(vertex_count, INFINITE_WEIGHT);
+    const LabelSet& forward = data_.forward;
+    for (size_t i = forward.offsets[from]; i < forward.offsets[from + 1]; ++i) {
+        hub_weights[forward.hubs[i]] = forward.weights[i];
+    }
+
+    std::vector<Weight> weights(vertex_count, INFINITE_WEIGHT);
+    const LabelSet& backward = data_.backward;
+    for (VertexId to = 0; to < vertex_count; ++to) {
+        for (size_t i = backward.offsets[to]; i < backward.offsets[to + 1]; ++i) {
+            const Weight hub_weight = hub_weights[backward.hubs[i]];
+            if (hub_weight != INFINITE_WEIGHT) {
+                weights[to] = std::min(weights[to], hub_weight + backward.weights[i]);
+            }
+        }
+    }
+    weights[from] = ZERO_WEIGHT;
+
+    return weights;
+}
+
+}  // namespace graph
@@ -1,5 +1,6 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include <algorithm>
 #include <sstream>
 
 namespace catalogue::reader {
@@ -23,10 +24,8 @@ void JsonReader::ProcessInQueries(TransportCatalogue& cat) {
         cat.AddStop(stop);
     }
 
-    for (const auto& [from, distances_to_stops] : stop_distances_) {
-        for (const auto& [to, distance] : distances_to_stops) {
-            cat.SetRoadDistance(from, to, distance);
-        }
+    for (const auto& [from, to, distance] : stop_distances_) {
+        cat.SetRoadDistance(from, to, distance);
     }
 
     for (auto& bus : bus_queries_) {
@@ -34,7 +33,38 @@ void JsonReader::ProcessInQueries(TransportCatalogue& cat) {
     }
 }
 
-void JsonReader::PrintOutQueries(TransportCatalogue& cat, const requests::RequestHandler& handler, std::ostream& out) {
+void JsonReader::ProcessUpdateQueries(TransportCatalogue& cat, requests::RequestHandler& handler) {
+    if (stop_queries_.empty() && bus_queries_.empty()) {
+        return;
+    }
+
+    handler.PrepareCatalogueUpdate();
+
+    for (const auto& stop : stop_queries_) {
+        cat.UpdateStop(stop);
+    }
+
+    std::vector<std::pair<StopId, StopId>> road_distances;
+    for (const auto& [from, to, distance] : stop_distances_) {
+        const auto from_id = cat.FindStopId(from);
+        const auto to_id = cat.FindStopId(to);
+        if (!from_id || !to_id) {
+            continue;
+        }
+        cat.SetRoadDistance(*from_id, *to_id, distance);
+        road_distances.emplace_back(*from_id, *to_id);
+    }
+
+    std::vector<const Bus*> buses;
+    for (auto& bus : bus_queries_) {
+        buses.push_back(cat.UpdateBus(bus.name, bus.stops, bus.is_roundtrip));
+    }
+
+    handler.OnCatalogueUpdate(buses, road_distances);
+    route_cache_.Clear();
+}
+
+void JsonReader::PrintOutQueries(const TransportCatalogue& cat, const requests::RequestHandler& handler, std::ostream& out) {
     json::Array to_print;
 
     for (const auto& query : out_queries_) {
@@ -51,6 +81,12 @@ void JsonReader::PrintOutQueries(TransportCatalogue& cat, const requests::Reques
             case OutQueryType::ROUTE:
                 to_print.push_back(FormRouteQuery(query, handler));
                 break;
+            case OutQueryType::ROUTE_MATRIX:
+                to_print.push_back(FormRouteMatrixQuery(query, handler));
+                break;
+            case OutQueryType::ISOCHRONE:
+                to_print.push_back(FormIsochroneQuery(query, handler));
+                break;
         }
     }
 
@@ -103,11 +139,11 @@ void JsonReader::ReadOutputQueries(const json::Array& out_queries) {
 
         if (type == "Stop"s) {
             out_queries_.push_back(
-                {id, OutQueryType::STOP, query.AsDict().at("name"s).AsString()}
+                {id, OutQueryType::STOP, InternName(query.AsDict().at("name"s).AsString())}
             );
         } else if (type == "Bus"s) {
             out_queries_.push_back(
-                {id, OutQueryType::BUS, query.AsDict().at("name"s).AsString()}
+                {id, OutQueryType::BUS, InternName(query.AsDict().at("name"s).AsString())}
             );
         } else if (type == "Map"s) {
             out_queries_.push_back(
@@ -115,7 +151,22 @@ void JsonReader::ReadOutputQueries(const json::Array& out_queries) {
             );
         } else if (type == "Route"s) {
             out_queries_.push_back(
-                {id, OutQueryType::ROUTE, RouteQueryInfo{query.AsDict().at("from"s).AsString(), query.AsDict().at("to"s).AsString()}}
+                {id, OutQueryType::ROUTE, RouteQueryInfo{InternName(query.AsDict().at("from"s).AsString()), InternName(query.AsDict().at("to"s).AsString())}}
+            );
+        } else if (type == "RouteMatrix"s) {
+            RouteMatrixQueryInfo matrix_info;
+            for (const auto& stop_name : query.AsDict().at("from"s).AsArray()) {
+                matrix_info.from.push_back(InternName(stop_name.AsString()));
+            }
+            for (const auto& stop_name : query.AsDict().at("to"s).AsArray()) {
+                matrix_info.to.push_back(InternName(stop_name.AsString()));
+            }
+            out_queries_.push_back(
+                {id, OutQueryType::ROUTE_MATRIX, std::move(matrix_info)}
+            );
+        } else if (type == "Isochrone"s) {
+            out_queries_.push_back(
+                {id, OutQueryType::ISOCHRONE, IsochroneQueryInfo{InternName(query.AsDict().at("from"s).AsString()), query.AsDict().at("max_time"s).AsDouble()}}
             );
         }
     }
@@ -177,6 +228,40 @@ void JsonReader::ReadRenderSettings(const json::Dict& settings_dict) {
 void JsonReader::ReadRoutingSettings(const json::Dict& settings) {
     routing_settings_.bus_wait_time = settings.at("bus_wait_time"s).AsInt();
     routing_settings_.bus_velocity = settings.at("bus_velocity").AsDouble() * KPH_TO_MPM;
+
+    if (settings.count("router"s) != 0) {
+        const std::string& router_type = settings.at("router"s).AsString();
+        if (router_type == "all_pairs"s) {
+            routing_settings_.router_type = domain::RouterType::ALL_PAIRS;
+        } else if (router_type == "dijkstra"s) {
+            routing_settings_.router_type = domain::RouterType::DIJKSTRA;
+        } else if (router_type == "raptor"s) {
+            routing_settings_.router_type = domain::RouterType::RAPTOR;
+        } else if (router_type == "contraction_hierarchy"s) {
+            routing_settings_.router_type = domain::RouterType::CONTRACTION_HIERARCHY;
+        } else if (router_type == "a_star"s) {
+            routing_settings_.router_type = domain::RouterType::A_STAR;
+        } else if (router_type == "hub_labels"s) {
+            routing_settings_.router_type = domain::RouterType::HUB_LABELS;
+        } else {
+            throw std::logic_error("Unknown router type.");
+        }
+    }
+
+    if (settings.count("graph_model"s) != 0) {
+        const std::string& graph_model = settings.at("graph_model"s).AsString();
+        if (graph_model == "wait_edges"s) {
+            routing_settings_.graph_model = domain::GraphModel::WAIT_EDGES;
+        } else if (graph_model == "single_vertex"s) {
+            routing_settings_.graph_model = domain::GraphModel::SINGLE_VERTEX;
+        } else {
+            throw std::logic_error("Unknown graph model.");
+        }
+    }
+
+    if (settings.count("thread_count"s) != 0) {
+        routing_settings_.thread_count = settings.at("thread_count"s).AsInt();
+    }
 }
 
 void JsonReader::ReadSerializationSettings(const json::Dict& settings) {
@@ -195,35 +280,49 @@ std::string JsonReader::GetDbName() const {
     return db_name_;
 }
 
+bool JsonReader::NeedsRouter() const {
+    return std::any_of(out_queries_.begin(), out_queries_.end(),
+        [](const OutQuery& query) {
+            return query.type == OutQueryType::ROUTE
+                || query.type == OutQueryType::ROUTE_MATRIX
+                || query.type == OutQueryType::ISOCHRONE;
+        }
+    );
+}
+
+std::string_view JsonReader::InternName(const std::string& name) {
+    return names_.GetName(names_.Intern(name));
+}
+
 void JsonReader::AddStopQuery(const json::Dict& query) {
 
-    std::string name = query.at("name"s).AsString();
+    std::string_view name = InternName(query.at("name"s).AsString());
     double lat = query.at("latitude"s).AsDouble();
     double lon = query.at("longitude"s).AsDouble();
 
     stop_queries_.push_back({name, {lat, lon}});
 
     for (const auto& [stop_name, distance] : query.at("road_distances"s).AsDict()) {
-        stop_distances_[name].insert({stop_name, distance.AsDouble()});
+        stop_distances_.push_back({name, InternName(stop_name), distance.AsDouble()});
     }
 
 }
 
 void JsonReader::AddBusQuery(const json::Dict& query) {
-    std::string name = query.at("name").AsString();
-    std::vector<std::string> stops;
+    std::string_view name = InternName(query.at("name").AsString());
+    std::vector<std::string_view> stops;
     bool is_roundtrip = true;
     for (const auto& stop_name : query.at("stops").AsArray()) {
-        stops.push_back(stop_name.AsString());
+        stops.push_back(InternName(stop_name.AsString()));
     }
 
     if (!query.at("is_roundtrip").AsBool()) {
-        std::vector<std::string> tmp{stops.rbegin() + 1, stops.rend()};
+        std::vector<std::string_view> tmp{stops.rbegin() + 1, stops.rend()};
         stops.insert(stops.end(), tmp.begin(), tmp.end());
         is_roundtrip = false;
     }
 
-    bus_queries_.push_back({name, stops, is_roundtrip});
+    bus_queries_.push_back({name, std::move(stops), is_roundtrip});
 }
 
 json::Node NotFound(int id) {
@@ -236,17 +335,19 @@ json::Node NotFound(int id) {
 }
 
 json::Node JsonReader::FormStopQuery(const OutQuery& query, const TransportCatalogue& cat) const {
-    auto bus_list = cat.GetBusesByStop(std::get<std::string>(query.payload));
+    const auto* bus_list = cat.GetBusesByStop(std::get<std::string_view>(query.payload));
     if (bus_list) {
-        std::set<std::string> buses_string;
-        for (const auto bus_sv : *bus_list) {
-            buses_string.insert(std::string(bus_sv));
+        // Названия в множестве уже упорядочены так же, как строки
+        json::Array buses;
+        buses.reserve(bus_list->size());
+        for (const std::string_view bus : *bus_list) {
+            buses.push_back(std::string(bus));
         }
 
         return json::Builder{}
             .StartDict()
                 .Key("buses"s)
-                    .Value(json::Array{buses_string.begin(), buses_string.end()})
+                    .Value(std::move(buses))
                 .Key("request_id"s).Value(query.id)
             .EndDict()
             .Build();
@@ -256,8 +357,8 @@ json::Node JsonReader::FormStopQuery(const OutQuery& query, const TransportCatal
     }
 }
 
-json::Node JsonReader::FormBusQuery(const OutQuery& query, TransportCatalogue& cat) const {
-    auto bus_info = cat.GetBusInfo(std::get<std::string>(query.payload));
+json::Node JsonReader::FormBusQuery(const OutQuery& query, const TransportCatalogue& cat) const {
+    auto bus_info = cat.GetBusInfo(std::get<std::string_view>(query.payload));
 
     if (bus_info) {
         return json::Builder{}
@@ -291,27 +392,63 @@ json::Node JsonReader::FormMapQuery(
         .Build();
 }
 
+// Повторяющиеся пары остановок отвечаются из кэша без поиска маршрута
 json::Node JsonReader::FormRouteQuery(
     const OutQuery& query,
     const requests::RequestHandler& handler
 ) const {
-    RouteQueryInfo route_info = std::get<RouteQueryInfo>(query.payload);
-    auto route = handler.FormRoute(route_info.from, route_info.to);
+    const auto& route_info = std::get<RouteQueryInfo>(query.payload);
+    const auto from = handler.GetRouter().FindStopVertex(route_info.from);
+    const auto to = handler.GetRouter().FindStopVertex(route_info.to);
+    if (!from || !to) {
+        return NotFound(query.id);
+    }
 
-    if (!route.has_value()) {
+    const RouteKey key{*from, *to};
+    std::shared_ptr<const RouteResponse> response;
+    if (auto cached = route_cache_.Get(key)) {
+        response = std::move(*cached);
+    } else {
+        response = MakeRouteResponse(route_info, handler);
+        route_cache_.Put(key, response);
+    }
+
+    if (!response) {
         return NotFound(query.id);
     }
 
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(query.id)
+            .Key("total_time"s).Value(response->total_time)
+            .Key("items"s).Value(response->items)
+        .EndDict()
+        .Build();
+}
+
+std::shared_ptr<const JsonReader::RouteResponse> JsonReader::MakeRouteResponse(
+    const RouteQueryInfo& route_info,
+    const requests::RequestHandler& handler
+) const {
+    // Части маршрута пишутся в буфер потока, который переиспользуется между запросами
+    static thread_local std::vector<router::TransportRouter::EdgeInfo> edges;
+    const auto total_time = handler.FormRoute(route_info.from, route_info.to, edges);
+
+    if (!total_time.has_value()) {
+        return nullptr;
+    }
+
     json::Array items;
+    items.reserve(edges.size());
 
-    for (const auto& i : route->edges) {
+    for (const auto& i : edges) {
         if (i.span_count == 0) {
             items.push_back(
                 json::Builder{}
                     .StartDict()
                         .Key("type"s).Value("Wait"s)
                         .Key("stop_name"s).Value(std::string(i.name))
-                        .Key("time"s).Value(i.time)
+                        .Key("time"s).Value(router::WeightToMinutes(i.time))
                     .EndDict()
                     .Build()
             );
@@ -322,18 +459,73 @@ json::Node JsonReader::FormRouteQuery(
                         .Key("type"s).Value("Bus"s)
                         .Key("bus"s).Value(std::string(i.name))
                         .Key("span_count"s).Value(static_cast<int>(i.span_count))
-                        .Key("time"s).Value(i.time)
+                        .Key("time"s).Value(router::WeightToMinutes(i.time))
                     .EndDict()
                     .Build()
             );
         }
     }
 
+    return std::make_shared<const RouteResponse>(
+        RouteResponse{router::WeightToMinutes(*total_time), std::move(items)}
+    );
+}
+
+// Строка i - времена в пути от from[i] до каждой остановки to, null - если маршрута нет
+json::Node JsonReader::FormRouteMatrixQuery(
+    const OutQuery& query,
+    const requests::RequestHandler& handler
+) const {
+    const auto& matrix_info = std::get<RouteMatrixQueryInfo>(query.payload);
+    const auto times = handler.FormRouteMatrix(matrix_info.from, matrix_info.to);
+
+    json::Array rows;
+    rows.reserve(times.size());
+    for (const auto& row_times : times) {
+        json::Array row;
+        row.reserve(row_times.size());
+        for (const auto& time : row_times) {
+            row.push_back(time ? json::Node(router::WeightToMinutes(*time)) : json::Node(nullptr));
+        }
+        rows.push_back(std::move(row));
+    }
+
+    return json::Builder{}
+        .StartDict()
+            .Key("request_id"s).Value(query.id)
+            .Key("total_times"s).Value(rows)
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::FormIsochroneQuery(
+    const OutQuery& query,
+    const requests::RequestHandler& handler
+) const {
+    const auto& isochrone_info = std::get<IsochroneQueryInfo>(query.payload);
+    const auto reached = handler.FormIsochrone(isochrone_info.from, router::MinutesToWeight(isochrone_info.max_time));
+
+    if (!reached.has_value()) {
+        return NotFound(query.id);
+    }
+
+    json::Array stops;
+    stops.reserve(reached->size());
+    for (const auto& stop : *reached) {
+        stops.push_back(
+            json::Builder{}
+                .StartDict()
+                    .Key("stop_name"s).Value(std::string(stop.name))
+                    .Key("time"s).Value(router::WeightToMinutes(stop.time))
+                .EndDict()
+                .Build()
+        );
+    }
+
     return json::Builder{}
         .StartDict()
             .Key("request_id"s).Value(query.id)
-            .Key("total_time"s).Value(route->total_time)
-            .Key("items"s).Value(items)
+            .Key("stops"s).Value(stops)
         .EndDict()
         .Build();
 }
@@ -1,9 +1,12 @@
 #pragma once
 #include "domain.h"
 #include "json.h"
+#include "lru_cache.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include <cstdint>
+#include <memory>
 #include <variant>
 
 namespace catalogue::reader {
@@ -13,49 +16,99 @@ public:
     JsonReader(std::istream& in);
 
     void ProcessInQueries(TransportCatalogue& cat);
+    // Применяет base_requests к уже построенной базе без её перестроения
+    void ProcessUpdateQueries(TransportCatalogue& cat, requests::RequestHandler& handler);
     void PrintOutQueries(
-        TransportCatalogue& cat,
+        const TransportCatalogue& cat,
         const requests::RequestHandler& handler,
         std::ostream& out
     );
     renderer::Settings GetRenderSettings() const;
     domain::RoutingSettings GetRoutingSettings() const;
     std::string GetDbName() const;
+    // Есть ли среди stat_requests запросы, которым нужен маршрутизатор
+    bool NeedsRouter() const;
 
 private:
+    static constexpr size_t ROUTE_CACHE_CAPACITY = 4096;
+
+    // Ответ на запрос маршрута без номера запроса
+    struct RouteResponse {
+        double total_time;
+        json::Array items;
+    };
+
+    using RouteKey = std::pair<graph::VertexId, graph::VertexId>;
+
+    // Номера вершин упаковываются в 64-битное число и перемешиваются
+    // умножением: std::hash от целого - само число, и сумма с множителем
+    // давала много совпадений у близких пар
+    struct RouteKeyHash {
+        size_t operator()(const RouteKey& key) const {
+            const uint64_t packed = (static_cast<uint64_t>(key.first) << 32) ^ key.second;
+            const uint64_t mixed = packed * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(mixed ^ (mixed >> 32));
+        }
+    };
+
+    // Кэш ответов на запросы маршрутов по паре вершин начала и конца. Ответы
+    // общие с кэшем, при попадании под мьютексом копируется только указатель;
+    // nullptr - маршрута нет
+    using RouteCache = cache::LruCache<RouteKey, std::shared_ptr<const RouteResponse>, RouteKeyHash>;
+
     struct BusQuery {
-        std::string name;
-        std::vector<std::string> stops;
+        std::string_view name;
+        std::vector<std::string_view> stops;
         bool is_roundtrip = true;
     };
 
+    struct DistanceQuery {
+        std::string_view from;
+        std::string_view to;
+        double distance;
+    };
+
     enum class OutQueryType {
         BUS,
         STOP,
         MAP,
         ROUTE,
+        ROUTE_MATRIX,
+        ISOCHRONE,
     };
 
     struct RouteQueryInfo {
-        std::string from;
-        std::string to;
+        std::string_view from;
+        std::string_view to;
+    };
+
+    struct RouteMatrixQueryInfo {
+        std::vector<std::string_view> from;
+        std::vector<std::string_view> to;
+    };
+
+    struct IsochroneQueryInfo {
+        std::string_view from;
+        double max_time;
     };
 
     struct OutQuery {
         int id;
         OutQueryType type;
-        std::variant<std::string, RouteQueryInfo> payload;
+        std::variant<std::string_view, RouteQueryInfo, RouteMatrixQueryInfo, IsochroneQueryInfo> payload;
     };
 
     std::string db_name_;
 
+    // Имена из base_requests и stat_requests, запросы ниже ссылаются на них
+    NameArena names_;
     std::vector<OutQuery> out_queries_;
-
     std::vector<Stop> stop_queries_;
     std::vector<BusQuery> bus_queries_;
-    std::unordered_map<std::string, std::unordered_map<std::string, double>> stop_distances_;
+    std::vector<DistanceQuery> stop_distances_;
     renderer::Settings render_settings_;
     domain::RoutingSettings routing_settings_;
+    mutable RouteCache route_cache_{ROUTE_CACHE_CAPACITY};
 
     void ReadDocument(std::istream& in);
     void ReadInputQueries(const json::Array& in_queries);
@@ -64,13 +117,19 @@ private:
     void ReadRoutingSettings(const json::Dict& settings);
     void ReadSerializationSettings(const json::Dict& settings);
 
+    std::string_view InternName(const std::string& name);
     void AddStopQuery(const json::Dict& query);
     void AddBusQuery(const json::Dict& query);
 
     json::Node FormStopQuery(const OutQuery& query, const TransportCatalogue& cat) const;
-    json::Node FormBusQuery(const OutQuery& query, TransportCatalogue& cat) const;
+    json::Node FormBusQuery(const OutQuery& query, const TransportCatalogue& cat) const;
     json::Node FormMapQuery(const OutQuery& query, const requests::RequestHandler& handler) const;
     json::Node FormRouteQuery(const OutQuery& query, const requests::RequestHandler& handler) const;
+    std::shared_ptr<const RouteResponse> MakeRouteResponse(
+        const RouteQueryInfo& route_info, const requests::RequestHandler& handler
+    ) const;
+    json::Node FormRouteMatrixQuery(const OutQuery& query, const requests::RequestHandler& handler) const;
+    json::Node FormIsochroneQuery(const OutQuery& query, const requests::RequestHandler& handler) const;
 };
 
 }
@@ -34,21 +34,28 @@ int main(int argc, char* argv[]) {
         JsonReader reader(std::cin);
         reader.ProcessInQueries(cat);
 
+        MapRenderer renderer(reader.GetRenderSettings());
+        RequestHandler handler(cat, renderer, reader.GetRoutingSettings());
+
         SaveToFile(
             std::filesystem::path(reader.GetDbName()),
             cat,
             reader.GetRenderSettings(),
-            reader.GetRoutingSettings()
+            reader.GetRoutingSettings(),
+            handler.GetRouter()
         );
 
     } else if (mode == "process_requests"sv) {
         JsonReader reader(std::cin);
 
-        auto [cat, renderer_settings, routings_settings] = FromFile(std::filesystem::path(reader.GetDbName()));
+        auto [cat, renderer_settings, routings_settings, router_state] = FromFile(
+            std::filesystem::path(reader.GetDbName()), reader.NeedsRouter()
+        );
 
         MapRenderer renderer(renderer_settings);
-        RequestHandler handler(cat, renderer, routings_settings);
+        RequestHandler handler(cat, renderer, routings_settings, std::move(router_state));
 
+        reader.ProcessUpdateQueries(cat, handler);
         reader.PrintOutQueries(cat, handler, std::cout);
 
     } else {
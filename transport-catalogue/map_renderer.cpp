@@ -15,6 +15,7 @@ MapRenderer::MapRenderer(Settings settings)
 }
 
 svg::Document MapRenderer::Render(
+    const TransportCatalogue& cat,
     const std::vector<const Bus*>& sorted_buses,
     const std::vector<const Stop*>& sorted_stops
 ) {
@@ -22,11 +23,11 @@ svg::Document MapRenderer::Render(
 
     svg::Document result;
 
-    for (const auto& route : RenderLines(sorted_buses)) {
+    for (const auto& route : RenderLines(cat, sorted_buses)) {
         result.Add(route);
     }
 
-    for (const auto& text : RenderBusNames(sorted_buses)) {
+    for (const auto& text : RenderBusNames(cat, sorted_buses)) {
         result.Add(text);
     }
 
@@ -42,6 +43,7 @@ svg::Document MapRenderer::Render(
 }
 
 std::vector<svg::Polyline> MapRenderer::RenderLines(
+    const TransportCatalogue& cat,
     const std::vector<const Bus*>& sorted_buses
 ) const {
     std::vector<svg::Polyline> result;
@@ -54,8 +56,8 @@ std::vector<svg::Polyline> MapRenderer::RenderLines(
         line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
         line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-        for (const auto* stop : sorted_buses[i]->stops) {
-            line.AddPoint(projector_(stop->coords));
+        for (const StopId stop : sorted_buses[i]->stops) {
+            line.AddPoint(projector_(cat.GetStopCoordinates(stop)));
         }
 
         result.push_back(line);
@@ -65,6 +67,7 @@ std::vector<svg::Polyline> MapRenderer::RenderLines(
 }
 
 std::vector<svg::Text> MapRenderer::RenderBusNames(
+    const TransportCatalogue& cat,
     const std::vector<const Bus*>& sorted_buses
 ) const {
     std::vector<svg::Text> result;
@@ -72,7 +75,7 @@ std::vector<svg::Text> MapRenderer::RenderBusNames(
     for (size_t i = 0; i < sorted_buses.size(); ++i) {
         VisualiseBusTexts(
             result,
-            sorted_buses[i]->stops[0]->coords,
+            cat.GetStopCoordinates(sorted_buses[i]->stops[0]),
             GetCurrentColor(i),
             sorted_buses[i]->name
         );
@@ -82,7 +85,7 @@ std::vector<svg::Text> MapRenderer::RenderBusNames(
             if (sorted_buses[i]->stops[0] != sorted_buses[i]->stops[end_stop_idx]) {
                 VisualiseBusTexts(
                     result,
-                    sorted_buses[i]->stops[end_stop_idx]->coords,
+                    cat.GetStopCoordinates(sorted_buses[i]->stops[end_stop_idx]),
                     GetCurrentColor(i),
                     sorted_buses[i]->name
                 );
@@ -97,7 +100,7 @@ void MapRenderer::VisualiseBusTexts(
     std::vector<svg::Text>& to,
     geo::Coordinates coords,
     svg::Color color,
-    const std::string& data
+    std::string_view data
 ) const {
     using namespace std::literals;
     svg::Text under_text;
@@ -109,7 +112,7 @@ void MapRenderer::VisualiseBusTexts(
         t->SetFontSize(settings_.bus_label_font_size);
         t->SetFontFamily("Verdana"s);
         t->SetFontWeight("bold"s);
-        t->SetData(data);
+        t->SetData(std::string(data));
     }
 
     under_text.SetFillColor(settings_.underlayer_color);
@@ -183,7 +186,7 @@ void MapRenderer::VisualiseStopTexts(
     std::vector<svg::Text>& to,
     geo::Coordinates coords,
     svg::Color color,
-    const std::string& data
+    std::string_view data
 ) const {
     using namespace std::literals;
     svg::Text under_text;
@@ -194,7 +197,7 @@ void MapRenderer::VisualiseStopTexts(
         t->SetOffset(settings_.stop_label_offset);
         t->SetFontSize(settings_.stop_label_font_size);
         t->SetFontFamily("Verdana"s);
-        t->SetData(data);
+        t->SetData(std::string(data));
     }
 
     under_text.SetFillColor(settings_.underlayer_color);
@@ -3,11 +3,13 @@
 #include "geo.h"
 #include "svg.h"
 #include "domain.h"
+#include "transport_catalogue.h"
 
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
+#include <string_view>
 #include <vector>
 
 namespace catalogue::renderer {
@@ -58,7 +60,9 @@ class MapRenderer {
 public:
     MapRenderer(Settings settings);
 
+    // Остановки автобусов берутся из справочника cat по номерам
     svg::Document Render(
+        const TransportCatalogue& cat,
         const std::vector<const Bus*>& sorted_buses,
         const std::vector<const Stop*>& sorted_stops
     );
@@ -73,21 +77,23 @@ private:
         std::vector<svg::Text>& to,
         geo::Coordinates coords,
         svg::Color color,
-        const std::string& data
+        std::string_view data
     ) const;
 
     void VisualiseStopTexts(
         std::vector<svg::Text>& to,
         geo::Coordinates coords,
         svg::Color color,
-        const std::string& data
+        std::string_view data
     ) const;
 
     std::vector<svg::Polyline> RenderLines(
+        const TransportCatalogue& cat,
         const std::vector<const Bus*>& sorted_buses
     ) const;
 
     std::vector<svg::Text> RenderBusNames(
+        const TransportCatalogue& cat,
         const std::vector<const Bus*>& sorted_buses
     ) const;
 
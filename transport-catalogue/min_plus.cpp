@@ -0,0 +1,243 @@
+#include "min_plus.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MIN_PLUS_X86 1
+#endif
+
+namespace graph {
+
+namespace {
+
+template <typename Weight>
+using RelaxRowFunction = void (*)(
+    const Weight*, const uint32_t*, Weight, uint32_t, Weight*, uint32_t*, size_t
+);
+
+template <typename Weight>
+void RelaxRowScalar(
+    const Weight* weights_through,
+    const uint32_t* prev_edges_through,
+    Weight weight_from,
+    uint32_t prev_edge_from,
+    Weight* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    RelaxRow<Weight, uint32_t>(
+        weights_through, prev_edges_through, weight_from, prev_edge_from, weights_from, prev_edges_from, count
+    );
+}
+
+#ifdef MIN_PLUS_X86
+
+// Бесконечный вес через вершину даёт бесконечного кандидата, который не меньше
+// никакого веса, поэтому отдельная проверка, как в скалярном цикле, не нужна.
+// Большинство блоков не улучшается, и запись в них пропускается
+
+__attribute__((target("avx2")))
+void RelaxRowAvx2(
+    const double* weights_through,
+    const uint32_t* prev_edges_through,
+    double weight_from,
+    uint32_t prev_edge_from,
+    double* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    const __m256d weight_from_vec = _mm256_set1_pd(weight_from);
+    const __m128i prev_edge_from_vec = _mm_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m128i no_edge_vec = _mm_set1_epi32(-1);
+    // Младшие половины 64-битных масок сравнения - маски для номеров рёбер
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    size_t vertex_to = 0;
+    for (; vertex_to + 4 <= count; vertex_to += 4) {
+        const __m256d candidate = _mm256_add_pd(weight_from_vec, _mm256_loadu_pd(weights_through + vertex_to));
+        const __m256d current = _mm256_loadu_pd(weights_from + vertex_to);
+        const __m256d improved = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(improved) == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(weights_from + vertex_to, _mm256_blendv_pd(current, candidate, improved));
+
+        const __m128i improved_edges = _mm256_castsi256_si128(
+            _mm256_permutevar8x32_epi32(_mm256_castpd_si256(improved), low_halves)
+        );
+        const __m128i through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + vertex_to));
+        const __m128i prev_edge = _mm_blendv_epi8(through, prev_edge_from_vec, _mm_cmpeq_epi32(through, no_edge_vec));
+        __m128i* prev_edges = reinterpret_cast<__m128i*>(prev_edges_from + vertex_to);
+        _mm_storeu_si128(prev_edges, _mm_blendv_epi8(_mm_loadu_si128(prev_edges), prev_edge, improved_edges));
+    }
+
+    RelaxRowScalar<double>(
+        weights_through + vertex_to, prev_edges_through + vertex_to, weight_from, prev_edge_from,
+        weights_from + vertex_to, prev_edges_from + vertex_to, count - vertex_to
+    );
+}
+
+__attribute__((target("avx512f,avx512vl")))
+void RelaxRowAvx512(
+    const double* weights_through,
+    const uint32_t* prev_edges_through,
+    double weight_from,
+    uint32_t prev_edge_from,
+    double* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    const __m512d weight_from_vec = _mm512_set1_pd(weight_from);
+    const __m256i prev_edge_from_vec = _mm256_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m256i no_edge_vec = _mm256_set1_epi32(-1);
+
+    size_t vertex_to = 0;
+    for (; vertex_to + 8 <= count; vertex_to += 8) {
+        const __m512d candidate = _mm512_add_pd(weight_from_vec, _mm512_loadu_pd(weights_through + vertex_to));
+        const __mmask8 improved = _mm512_cmp_pd_mask(candidate, _mm512_loadu_pd(weights_from + vertex_to), _CMP_LT_OQ);
+        if (improved == 0) {
+            continue;
+        }
+        _mm512_mask_storeu_pd(weights_from + vertex_to, improved, candidate);
+
+        const __m256i through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + vertex_to));
+        const __m256i prev_edge = _mm256_mask_blend_epi32(
+            _mm256_cmpeq_epi32_mask(through, no_edge_vec), through, prev_edge_from_vec
+        );
+        _mm256_mask_storeu_epi32(prev_edges_from + vertex_to, improved, prev_edge);
+    }
+
+    RelaxRowScalar<double>(
+        weights_through + vertex_to, prev_edges_through + vertex_to, weight_from, prev_edge_from,
+        weights_from + vertex_to, prev_edges_from + vertex_to, count - vertex_to
+    );
+}
+
+// У целых весов бесконечность - наибольшее значение, и сумма с ней переполняется,
+// поэтому бесконечные веса через вершину исключаются явно
+
+__attribute__((target("avx2")))
+void RelaxRowAvx2(
+    const uint32_t* weights_through,
+    const uint32_t* prev_edges_through,
+    uint32_t weight_from,
+    uint32_t prev_edge_from,
+    uint32_t* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    const __m256i weight_from_vec = _mm256_set1_epi32(static_cast<int>(weight_from));
+    const __m256i prev_edge_from_vec = _mm256_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m256i all_ones = _mm256_set1_epi32(-1);
+
+    size_t vertex_to = 0;
+    for (; vertex_to + 8 <= count; vertex_to += 8) {
+        const __m256i weight_to = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights_through + vertex_to));
+        const __m256i candidate = _mm256_add_epi32(weight_from_vec, weight_to);
+        __m256i* weights = reinterpret_cast<__m256i*>(weights_from + vertex_to);
+        const __m256i current = _mm256_loadu_si256(weights);
+        // Сравнения беззнаковые: current <= candidate, если min(candidate, current) == current
+        const __m256i not_improved = _mm256_or_si256(
+            _mm256_cmpeq_epi32(_mm256_min_epu32(candidate, current), current),
+            _mm256_cmpeq_epi32(weight_to, all_ones)
+        );
+        if (_mm256_movemask_epi8(not_improved) == -1) {
+            continue;
+        }
+        _mm256_storeu_si256(weights, _mm256_blendv_epi8(candidate, current, not_improved));
+
+        const __m256i through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges_through + vertex_to));
+        const __m256i prev_edge = _mm256_blendv_epi8(through, prev_edge_from_vec, _mm256_cmpeq_epi32(through, all_ones));
+        __m256i* prev_edges = reinterpret_cast<__m256i*>(prev_edges_from + vertex_to);
+        _mm256_storeu_si256(prev_edges, _mm256_blendv_epi8(prev_edge, _mm256_loadu_si256(prev_edges), not_improved));
+    }
+
+    RelaxRowScalar<uint32_t>(
+        weights_through + vertex_to, prev_edges_through + vertex_to, weight_from, prev_edge_from,
+        weights_from + vertex_to, prev_edges_from + vertex_to, count - vertex_to
+    );
+}
+
+__attribute__((target("avx512f")))
+void RelaxRowAvx512(
+    const uint32_t* weights_through,
+    const uint32_t* prev_edges_through,
+    uint32_t weight_from,
+    uint32_t prev_edge_from,
+    uint32_t* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    const __m512i weight_from_vec = _mm512_set1_epi32(static_cast<int>(weight_from));
+    const __m512i prev_edge_from_vec = _mm512_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m512i all_ones = _mm512_set1_epi32(-1);
+
+    size_t vertex_to = 0;
+    for (; vertex_to + 16 <= count; vertex_to += 16) {
+        const __m512i weight_to = _mm512_loadu_si512(weights_through + vertex_to);
+        const __m512i candidate = _mm512_add_epi32(weight_from_vec, weight_to);
+        const __mmask16 improved = _mm512_mask_cmplt_epu32_mask(
+            _mm512_cmpneq_epi32_mask(weight_to, all_ones), candidate, _mm512_loadu_si512(weights_from + vertex_to)
+        );
+        if (improved == 0) {
+            continue;
+        }
+        _mm512_mask_storeu_epi32(weights_from + vertex_to, improved, candidate);
+
+        const __m512i through = _mm512_loadu_si512(prev_edges_through + vertex_to);
+        const __m512i prev_edge = _mm512_mask_blend_epi32(
+            _mm512_cmpeq_epi32_mask(through, all_ones), through, prev_edge_from_vec
+        );
+        _mm512_mask_storeu_epi32(prev_edges_from + vertex_to, improved, prev_edge);
+    }
+
+    RelaxRowScalar<uint32_t>(
+        weights_through + vertex_to, prev_edges_through + vertex_to, weight_from, prev_edge_from,
+        weights_from + vertex_to, prev_edges_from + vertex_to, count - vertex_to
+    );
+}
+
+#endif
+
+template <typename Weight>
+RelaxRowFunction<Weight> SelectRelaxRow() {
+#ifdef MIN_PLUS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl")) {
+        return RelaxRowAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return RelaxRowAvx2;
+    }
+#endif
+    return RelaxRowScalar<Weight>;
+}
+
+}  // namespace
+
+void RelaxRow(
+    const double* weights_through,
+    const uint32_t* prev_edges_through,
+    double weight_from,
+    uint32_t prev_edge_from,
+    double* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    static const RelaxRowFunction<double> relax_row = SelectRelaxRow<double>();
+    relax_row(weights_through, prev_edges_through, weight_from, prev_edge_from, weights_from, prev_edges_from, count);
+}
+
+void RelaxRow(
+    const uint32_t* weights_through,
+    const uint32_t* prev_edges_through,
+    uint32_t weight_from,
+    uint32_t prev_edge_from,
+    uint32_t* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+) {
+    static const RelaxRowFunction<uint32_t> relax_row = SelectRelaxRow<uint32_t>();
+    relax_row(weights_through, prev_edges_through, weight_from, prev_edge_from, weights_from, prev_edges_from, count);
+}
+
+}  // namespace graph
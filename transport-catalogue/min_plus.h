@@ -0,0 +1,65 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace graph {
+
+// Релаксация строки таблицы маршрутов через промежуточную вершину:
+// weights_from[j] = min(weights_from[j], weight_from + weights_through[j]).
+// При улучшении последним ребром становится последнее ребро пути через
+// промежуточную вершину, а если его нет - prev_edge_from. weight_from конечен
+template <typename Weight, typename EdgeIdType>
+void RelaxRow(
+    const Weight* weights_through,
+    const EdgeIdType* prev_edges_through,
+    Weight weight_from,
+    EdgeIdType prev_edge_from,
+    Weight* weights_from,
+    EdgeIdType* prev_edges_from,
+    size_t count
+) {
+    constexpr Weight infinite_weight = InfiniteWeight<Weight>();
+    constexpr EdgeIdType no_edge = std::numeric_limits<EdgeIdType>::max();
+
+    for (size_t vertex_to = 0; vertex_to < count; ++vertex_to) {
+        const Weight weight_to = weights_through[vertex_to];
+        if (weight_to == infinite_weight) {
+            continue;
+        }
+        const Weight candidate_weight = weight_from + weight_to;
+        if (candidate_weight < weights_from[vertex_to]) {
+            weights_from[vertex_to] = candidate_weight;
+            prev_edges_from[vertex_to] = prev_edges_through[vertex_to] != no_edge
+                ? prev_edges_through[vertex_to]
+                : prev_edge_from;
+        }
+    }
+}
+
+// Векторные версии для весов double и целых весов uint32_t: набор инструкций
+// (AVX-512, AVX2) выбирается при первом вызове по возможностям процессора,
+// иначе используется скалярный цикл. Результат совпадает побитно
+void RelaxRow(
+    const double* weights_through,
+    const uint32_t* prev_edges_through,
+    double weight_from,
+    uint32_t prev_edge_from,
+    double* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+);
+
+void RelaxRow(
+    const uint32_t* weights_through,
+    const uint32_t* prev_edges_through,
+    uint32_t weight_from,
+    uint32_t prev_edge_from,
+    uint32_t* weights_from,
+    uint32_t* prev_edges_from,
+    size_t count
+);
+
+}  // namespace graph
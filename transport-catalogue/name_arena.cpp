@@ -0,0 +1,90 @@
+#include "name_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace catalogue {
+
+NameArena::NameId NameArena::Intern(std::string_view name) {
+    // Заполненность таблицы не больше 3/4
+    if ((names_.size() + 1) * 4 > slots_.size() * 3) {
+        Grow();
+    }
+
+    const size_t hash = std::hash<std::string_view>{}(name);
+    const size_t slot = FindSlot(name, hash);
+    if (slots_[slot] != NO_NAME) {
+        return slots_[slot];
+    }
+
+    const NameId id = static_cast<NameId>(names_.size());
+    names_.push_back(Store(name));
+    hashes_.push_back(hash);
+    slots_[slot] = id;
+    return id;
+}
+
+std::optional<NameArena::NameId> NameArena::Find(std::string_view name) const {
+    if (names_.empty()) {
+        return std::nullopt;
+    }
+    const NameId id = slots_[FindSlot(name, std::hash<std::string_view>{}(name))];
+    if (id == NO_NAME) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::string_view NameArena::GetName(NameId id) const {
+    return names_[id];
+}
+
+size_t NameArena::GetSize() const {
+    return names_.size();
+}
+
+// Копирует имя в текущий блок, а если оно не помещается - в новый.
+// Имя длиннее блока получает отдельный блок своего размера.
+// Пустому имени место не нужно, а блоков до первого непустого имени ещё нет
+std::string_view NameArena::Store(std::string_view name) {
+    if (name.empty()) {
+        return {};
+    }
+    if (name.size() > block_size_ - block_used_) {
+        block_size_ = std::max(BLOCK_SIZE, name.size());
+        blocks_.push_back(std::make_unique<char[]>(block_size_));
+        block_used_ = 0;
+    }
+    char* data = blocks_.back().get() + block_used_;
+    std::memcpy(data, name.data(), name.size());
+    block_used_ += name.size();
+    return {data, name.size()};
+}
+
+// Слот с именем name либо пустой слот, в который его нужно записать
+size_t NameArena::FindSlot(std::string_view name, size_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    size_t slot = hash & mask;
+    while (slots_[slot] != NO_NAME
+        && (hashes_[slots_[slot]] != hash || names_[slots_[slot]] != name)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void NameArena::Grow() {
+    const size_t capacity = std::max(slots_.size() * 2, MIN_CAPACITY);
+    slots_.assign(capacity, NO_NAME);
+
+    const size_t mask = capacity - 1;
+    for (NameId id = 0; id < names_.size(); ++id) {
+        size_t slot = hashes_[id] & mask;
+        while (slots_[slot] != NO_NAME) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = id;
+    }
+}
+
+}
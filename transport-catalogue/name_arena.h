@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace catalogue {
+
+// Хранилище имён: каждое имя копируется один раз в общий буфер из крупных
+// блоков и получает номер по порядку добавления. Блоки не перевыделяются,
+// поэтому string_view на имена остаются действительными всё время жизни
+// хранилища, в том числе после его перемещения.
+// Хеш имени вычисляется один раз при добавлении и хранится рядом с ним
+class NameArena {
+public:
+    using NameId = uint32_t;
+
+    // Номер имени, при первом появлении имя копируется в буфер
+    NameId Intern(std::string_view name);
+    std::optional<NameId> Find(std::string_view name) const;
+
+    std::string_view GetName(NameId id) const;
+    size_t GetSize() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr NameId NO_NAME = UINT32_MAX;
+
+    std::string_view Store(std::string_view name);
+    size_t FindSlot(std::string_view name, size_t hash) const;
+    void Grow();
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_used_ = 0;
+    size_t block_size_ = 0;
+
+    std::vector<std::string_view> names_;
+    std::vector<size_t> hashes_;
+    // Открытая адресация: в слоте номер имени или NO_NAME
+    std::vector<NameId> slots_;
+};
+
+}
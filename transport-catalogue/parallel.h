@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace parallel {
+
+// Число потоков: запрошенное либо, если запрошен 0, число ядер процессора
+inline size_t GetThreadCount(size_t requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// Точка синхронизации: Wait возвращает управление, когда до неё дойдут все потоки
+class Barrier {
+public:
+    explicit Barrier(size_t thread_count)
+        : thread_count_(thread_count)
+        , waiting_(0)
+        , generation_(0) {
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++waiting_ == thread_count_) {
+            waiting_ = 0;
+            ++generation_;
+            cv_.notify_all();
+            return;
+        }
+        cv_.wait(lock, [this, generation] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    const size_t thread_count_;
+    size_t waiting_;
+    size_t generation_;
+};
+
+}  // namespace parallel
@@ -0,0 +1,166 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace catalogue::router {
+
+namespace {
+
+constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+constexpr size_t NO_POSITION = std::numeric_limits<size_t>::max();
+
+}
+
+RaptorRouter::RaptorRouter(size_t stop_count, std::vector<Line> lines, double wait_time, double velocity)
+    : stop_count_(stop_count)
+    , lines_(std::move(lines))
+    , stop_lines_(stop_count)
+    , wait_time_(wait_time)
+    , velocity_(velocity)
+{
+    for (size_t line_id = 0; line_id < lines_.size(); ++line_id) {
+        const auto& stops = lines_[line_id].stops;
+        for (size_t pos = 0; pos < stops.size(); ++pos) {
+            stop_lines_.at(stops[pos]).emplace_back(line_id, pos);
+        }
+    }
+}
+
+std::optional<RaptorRouter::RouteInfo> RaptorRouter::BuildRoute(size_t from, size_t to) const {
+    if (from >= stop_count_ || to >= stop_count_) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+
+    const auto [best, round_labels, round_improved] = Search(from, to, INFINITE_TIME);
+
+    if (best[to] == INFINITE_TIME) {
+        return std::nullopt;
+    }
+
+    RouteInfo result{best[to], {}};
+    size_t round = round_labels.size();
+    for (size_t stop = to; stop != from; --round) {
+        while (!round_improved[round - 1][stop]) {
+            --round;
+            assert(round > 0);
+        }
+        const Leg& leg = round_labels[round - 1][stop].leg;
+        result.legs.push_back(leg);
+        stop = lines_[leg.line_id].stops[leg.board_pos];
+    }
+    std::reverse(result.legs.begin(), result.legs.end());
+
+    return result;
+}
+
+std::vector<double> RaptorRouter::ComputeTimes(size_t from, double max_time) const {
+    if (from >= stop_count_) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+    return Search(from, std::nullopt, max_time).best;
+}
+
+RaptorRouter::SearchResult RaptorRouter::Search(
+    size_t from, std::optional<size_t> target, double max_time
+) const {
+    SearchResult result;
+    auto& [best, round_labels, round_improved] = result;
+
+    // prev_round[s] - лучшее время прибытия не более чем с k - 1 посадками,
+    // с которым можно сесть в k-м раунде
+    best.assign(stop_count_, INFINITE_TIME);
+    std::vector<double> prev_round(stop_count_, INFINITE_TIME);
+    best[from] = prev_round[from] = 0;
+
+    std::vector<size_t> line_start(lines_.size(), NO_POSITION);
+    std::vector<size_t> queued_lines;
+    std::vector<size_t> marked{from};
+
+    while (!marked.empty()) {
+        // Каждый участок достаточно просмотреть один раз, начиная с самой
+        // ранней остановки, улучшенной в предыдущем раунде
+        for (const size_t stop : marked) {
+            for (const auto& [line_id, pos] : stop_lines_[stop]) {
+                if (line_start[line_id] == NO_POSITION) {
+                    queued_lines.push_back(line_id);
+                    line_start[line_id] = pos;
+                } else {
+                    line_start[line_id] = std::min(line_start[line_id], pos);
+                }
+            }
+        }
+        marked.clear();
+
+        auto& labels = round_labels.emplace_back(stop_count_);
+        auto& improved = round_improved.emplace_back(stop_count_, false);
+
+        for (const size_t line_id : queued_lines) {
+            ScanLine(line_id, line_start[line_id], prev_round, best, labels, improved, marked, target, max_time);
+            line_start[line_id] = NO_POSITION;
+        }
+        queued_lines.clear();
+
+        for (const size_t stop : marked) {
+            prev_round[stop] = best[stop];
+        }
+    }
+
+    return result;
+}
+
+const RaptorRouter::Line& RaptorRouter::GetLine(size_t line_id) const {
+    return lines_.at(line_id);
+}
+
+double RaptorRouter::GetWaitTime() const {
+    return wait_time_;
+}
+
+double RaptorRouter::GetTravelTime(const Leg& leg) const {
+    const auto& distances = lines_.at(leg.line_id).distances;
+    return (distances[leg.alight_pos] - distances[leg.board_pos]) / velocity_;
+}
+
+void RaptorRouter::ScanLine(
+    size_t line_id,
+    size_t start_pos,
+    const std::vector<double>& prev_round,
+    std::vector<double>& best,
+    std::vector<Label>& labels,
+    std::vector<bool>& improved,
+    std::vector<size_t>& marked,
+    std::optional<size_t> target,
+    double max_time
+) const {
+    const Line& line = lines_[line_id];
+    size_t board_pos = NO_POSITION;
+    double board_time = INFINITE_TIME;
+
+    for (size_t pos = start_pos; pos < line.stops.size(); ++pos) {
+        const size_t stop = line.stops[pos];
+        double arrival = INFINITE_TIME;
+
+        if (board_pos != NO_POSITION) {
+            arrival = board_time + (line.distances[pos] - line.distances[board_pos]) / velocity_;
+            if (arrival < best[stop] && arrival <= max_time && (!target || arrival < best[*target])) {
+                best[stop] = arrival;
+                labels[stop] = {arrival, {line_id, board_pos, pos}};
+                if (!improved[stop]) {
+                    improved[stop] = true;
+                    marked.push_back(stop);
+                }
+            }
+        }
+
+        // Садимся здесь, если ещё не едем или если новая посадка даст более раннее прибытие
+        if (prev_round[stop] != INFINITE_TIME && prev_round[stop] + wait_time_ < arrival) {
+            board_pos = pos;
+            board_time = prev_round[stop] + wait_time_;
+        }
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace catalogue::router {
+
+// Поиск маршрутов по раундам (RAPTOR): k-й раунд находит лучшие времена
+// прибытия на остановки ровно с k посадками, просматривая последовательности
+// остановок автобусов. Граф пар остановок при этом не строится
+class RaptorRouter {
+public:
+    // Участок маршрута автобуса, по которому можно ехать без пересадки
+    struct Line {
+        std::string_view bus_name;
+        std::vector<size_t> stops;
+        // distances[i] - расстояние по дорогам от начала маршрута до stops[i]
+        std::vector<double> distances;
+    };
+
+    struct Leg {
+        size_t line_id;
+        size_t board_pos;
+        size_t alight_pos;
+    };
+
+    struct RouteInfo {
+        double weight;
+        std::vector<Leg> legs;
+    };
+
+    RaptorRouter(size_t stop_count, std::vector<Line> lines, double wait_time, double velocity);
+
+    std::optional<RouteInfo> BuildRoute(size_t from, size_t to) const;
+    // Время в пути от from до каждой остановки, бесконечное для недостижимых
+    // и для тех, куда нельзя добраться за max_time
+    std::vector<double> ComputeTimes(
+        size_t from, double max_time = std::numeric_limits<double>::infinity()
+    ) const;
+
+    const Line& GetLine(size_t line_id) const;
+    double GetWaitTime() const;
+    double GetTravelTime(const Leg& leg) const;
+
+private:
+    struct Label {
+        double time;
+        Leg leg;
+    };
+
+    // best[s] - лучшее найденное время прибытия на остановку s; labels[k][s] -
+    // последняя поездка к s, найденная в раунде k, если improved[k][s]
+    struct SearchResult {
+        std::vector<double> best;
+        std::vector<std::vector<Label>> round_labels;
+        std::vector<std::vector<bool>> round_improved;
+    };
+
+    size_t stop_count_;
+    std::vector<Line> lines_;
+    // Для каждой остановки - пары (участок, позиция на участке)
+    std::vector<std::vector<std::pair<size_t, size_t>>> stop_lines_;
+    double wait_time_;
+    double velocity_;
+
+    // Если target не задан, ищутся времена до всех остановок. Прибытия
+    // позже max_time отбрасываются
+    SearchResult Search(size_t from, std::optional<size_t> target, double max_time) const;
+    void ScanLine(
+        size_t line_id,
+        size_t start_pos,
+        const std::vector<double>& prev_round,
+        std::vector<double>& best,
+        std::vector<Label>& labels,
+        std::vector<bool>& improved,
+        std::vector<size_t>& marked,
+        std::optional<size_t> target,
+        double max_time
+    ) const;
+};
+
+}
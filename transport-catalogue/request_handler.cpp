@@ -5,23 +5,101 @@ namespace catalogue::requests {
 RequestHandler::RequestHandler(
     const TransportCatalogue& cat,
     renderer::MapRenderer& renderer,
-    domain::RoutingSettings routing_settings
+    domain::RoutingSettings routing_settings,
+    std::optional<router::TransportRouter::State> router_state
 ) : cat_(cat)
-  , sorted_stops_(GetSortedStops())
-  , sorted_buses_(GetSortedBuses())
   , renderer_(renderer)
-  , transport_router_(sorted_stops_, sorted_buses_, cat_, routing_settings)
+  , routing_settings_(std::move(routing_settings))
+  , router_state_(std::move(router_state))
 {
+    if (router_state_) {
+        GetSorted();
+    }
 }
 
 svg::Document RequestHandler::RenderMap() const {
-    return renderer_.Render(sorted_buses_, sorted_stops_);
+    const SortedItems& sorted = GetSorted();
+    return renderer_.Render(cat_, sorted.buses, sorted.stops);
+}
+
+const router::TransportRouter& RequestHandler::GetRouter() const {
+    std::call_once(router_flag_, [this] {
+        const SortedItems& sorted = GetSorted();
+        transport_router_.emplace(sorted.stops, sorted.buses, cat_, routing_settings_, std::move(router_state_));
+        router_state_.reset();
+    });
+    return *transport_router_;
 }
 
 std::optional<catalogue::router::TransportRouter::RouteInfo> RequestHandler::FormRoute(
-    const std::string& from, const std::string& to
+    std::string_view from, std::string_view to
+) const {
+    return GetRouter().BuildRoute(from, to);
+}
+
+std::optional<catalogue::router::RouteWeight> RequestHandler::FormRoute(
+    std::string_view from,
+    std::string_view to,
+    std::vector<catalogue::router::TransportRouter::EdgeInfo>& edges
+) const {
+    return GetRouter().BuildRoute(from, to, edges);
+}
+
+std::optional<catalogue::router::RouteWeight> RequestHandler::FormRoute(
+    StopId from,
+    StopId to,
+    std::vector<catalogue::router::TransportRouter::EdgeInfo>& edges
+) const {
+    return GetRouter().BuildRoute(from, to, edges);
+}
+
+catalogue::router::TransportRouter::TimeMatrix RequestHandler::FormRouteMatrix(
+    const std::vector<std::string_view>& from, const std::vector<std::string_view>& to
+) const {
+    return GetRouter().BuildTimeMatrix(from, to);
+}
+
+std::optional<std::vector<catalogue::router::TransportRouter::ReachedStop>> RequestHandler::FormIsochrone(
+    std::string_view from, catalogue::router::RouteWeight max_time
 ) const {
-    return transport_router_.BuildRoute(from, to);
+    return GetRouter().BuildIsochrone(from, max_time);
+}
+
+std::optional<std::vector<catalogue::router::TransportRouter::ReachedStop>> RequestHandler::FormIsochrone(
+    StopId from, catalogue::router::RouteWeight max_time
+) const {
+    return GetRouter().BuildIsochrone(from, max_time);
+}
+
+void RequestHandler::PrepareCatalogueUpdate() {
+    // Автобусы меняются в справочнике на месте. Если собрать маршрутизатор
+    // после этого, RAPTOR строит участки по новым остановкам автобусов,
+    // которых нет в старых списках
+    if (router_state_) {
+        GetRouter();
+    }
+}
+
+void RequestHandler::OnCatalogueUpdate(
+    const std::vector<const Bus*>& buses,
+    const std::vector<std::pair<StopId, StopId>>& road_distances
+) {
+    // Маршрутизатор из базы исправляется частично. Если его не будет,
+    // он строится позже по новому справочнику
+    PrepareCatalogueUpdate();
+    if (transport_router_) {
+        transport_router_->Update(buses, road_distances);
+    }
+    sorted_flag_ = std::make_unique<std::once_flag>();
+    sorted_ = {};
+}
+
+const RequestHandler::SortedItems& RequestHandler::GetSorted() const {
+    std::call_once(*sorted_flag_, [this] {
+        sorted_.stops = GetSortedStops();
+        sorted_.buses = GetSortedBuses();
+    });
+    return sorted_;
 }
 
 template <typename T>
@@ -52,13 +130,19 @@ std::vector<const Bus*> RequestHandler::GetSortedBuses() const {
 }
 
 std::vector<const Stop*> RequestHandler::GetSortedStops() const {
-    std::set<const Stop*> stops_set;
-
+    std::vector<bool> is_used(cat_.GetStopCount(), false);
     for (const auto& bus : cat_.GetBuses()) {
-        stops_set.insert(bus.stops.begin(), bus.stops.end());
+        for (const StopId stop : bus.stops) {
+            is_used[stop] = true;
+        }
     }
 
-    std::vector<const Stop*> sorted_stops(stops_set.begin(), stops_set.end());
+    std::vector<const Stop*> sorted_stops;
+    for (StopId stop = 0; stop < is_used.size(); ++stop) {
+        if (is_used[stop]) {
+            sorted_stops.push_back(&cat_.GetStop(stop));
+        }
+    }
 
     SortByName(sorted_stops);
 
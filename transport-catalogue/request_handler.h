@@ -3,29 +3,82 @@
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <memory>
+#include <mutex>
+
 namespace catalogue::requests {
 
+// Отсортированные списки и маршрутизатор строятся при первом обращении,
+// один раз и потокобезопасно: пакеты без запросов маршрутов их не строят
 class RequestHandler {
 public:
+    // router_state передаётся, только если маршрутизатор понадобится: списки,
+    // для которых оно построено, запоминаются до изменений справочника
     RequestHandler(
         const TransportCatalogue& cat,
         renderer::MapRenderer& renderer,
-        domain::RoutingSettings routing_settings
+        domain::RoutingSettings routing_settings,
+        std::optional<router::TransportRouter::State> router_state = std::nullopt
     );
 
     svg::Document RenderMap() const;
 
+    const router::TransportRouter& GetRouter() const;
+
     std::optional<catalogue::router::TransportRouter::RouteInfo> FormRoute(
-        const std::string& from, const std::string& to
+        std::string_view from, std::string_view to
+    ) const;
+    // Части маршрута записываются в edges, возвращается время в пути
+    std::optional<catalogue::router::RouteWeight> FormRoute(
+        std::string_view from,
+        std::string_view to,
+        std::vector<catalogue::router::TransportRouter::EdgeInfo>& edges
+    ) const;
+    std::optional<catalogue::router::RouteWeight> FormRoute(
+        StopId from,
+        StopId to,
+        std::vector<catalogue::router::TransportRouter::EdgeInfo>& edges
     ) const;
 
+    catalogue::router::TransportRouter::TimeMatrix FormRouteMatrix(
+        const std::vector<std::string_view>& from, const std::vector<std::string_view>& to
+    ) const;
+
+    std::optional<std::vector<catalogue::router::TransportRouter::ReachedStop>> FormIsochrone(
+        std::string_view from, catalogue::router::RouteWeight max_time
+    ) const;
+    std::optional<std::vector<catalogue::router::TransportRouter::ReachedStop>> FormIsochrone(
+        StopId from, catalogue::router::RouteWeight max_time
+    ) const;
+
+    // Вызывается до изменения справочника: маршрутизатор из базы собирается
+    // по автобусам, для которых построено его состояние
+    void PrepareCatalogueUpdate();
+    // Вызывается после изменения автобусов или расстояний в справочнике
+    void OnCatalogueUpdate(
+        const std::vector<const Bus*>& buses,
+        const std::vector<std::pair<StopId, StopId>>& road_distances
+    );
+
 private:
+    struct SortedItems {
+        std::vector<const Stop*> stops;
+        std::vector<const Bus*> buses;
+    };
+
     const TransportCatalogue& cat_;
-    const std::vector<const Stop*> sorted_stops_;
-    const std::vector<const Bus*> sorted_buses_;
     renderer::MapRenderer& renderer_;
-    const catalogue::router::TransportRouter transport_router_;
+    domain::RoutingSettings routing_settings_;
+    // Состояние из базы до построения маршрутизатора
+    mutable std::optional<router::TransportRouter::State> router_state_;
+
+    // Флаг списков пересоздаётся после изменения справочника
+    mutable std::unique_ptr<std::once_flag> sorted_flag_ = std::make_unique<std::once_flag>();
+    mutable SortedItems sorted_;
+    mutable std::once_flag router_flag_;
+    mutable std::optional<router::TransportRouter> transport_router_;
 
+    const SortedItems& GetSorted() const;
     std::vector<const Stop*> GetSortedStops() const;
     std::vector<const Bus*> GetSortedBuses() const;
 };
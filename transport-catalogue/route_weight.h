@@ -0,0 +1,38 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace catalogue::router {
+
+// Вес рёбер графа и маршрутов. При сборке с TRANSPORT_CATALOGUE_FIXED_POINT_WEIGHT
+// время хранится целым числом десятых долей секунды: таблица маршрутов вдвое
+// меньше, а сравнения точные. Иначе время хранится в минутах.
+// В минуты вес переводится только при выводе ответов
+#ifdef TRANSPORT_CATALOGUE_FIXED_POINT_WEIGHT
+using RouteWeight = uint32_t;
+inline constexpr double WEIGHT_UNITS_PER_MINUTE = 600;
+inline constexpr bool IS_FIXED_POINT_WEIGHT = true;
+
+inline RouteWeight MinutesToWeight(double minutes) {
+    return static_cast<RouteWeight>(std::llround(minutes * WEIGHT_UNITS_PER_MINUTE));
+}
+#else
+using RouteWeight = double;
+inline constexpr double WEIGHT_UNITS_PER_MINUTE = 1;
+inline constexpr bool IS_FIXED_POINT_WEIGHT = false;
+
+inline RouteWeight MinutesToWeight(double minutes) {
+    return minutes;
+}
+#endif
+
+inline constexpr RouteWeight INFINITE_ROUTE_WEIGHT = graph::InfiniteWeight<RouteWeight>();
+
+inline double WeightToMinutes(RouteWeight weight) {
+    return weight / WEIGHT_UNITS_PER_MINUTE;
+}
+
+}  // namespace catalogue::router
@@ -1,117 +1,676 @@
 #pragma once
 
 #include "graph.h"
+#include "min_plus.h"
+#include "parallel.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <numeric>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
-template <typename Weight>
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
 class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
 public:
-    explicit Router(const Graph& graph);
+    using CompactEdgeId = uint32_t;
+    static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+    static constexpr Weight INFINITE_WEIGHT = InfiniteWeight<Weight>();
+
+    // Таблица маршрутов между всеми парами вершин. Граф разбит на компоненты
+    // слабой связности, между вершинами разных компонент маршрутов нет, поэтому
+    // для каждой компоненты хранится своя квадратная таблица. Внутри компоненты
+    // вершины нумеруются по возрастанию, веса и последние рёбра путей хранятся
+    // построчно в двух непрерывных массивах. Отсутствие маршрута обозначается
+    // бесконечным весом, отсутствие ребра - NO_EDGE
+    class RoutesInternalData {
+    public:
+        RoutesInternalData() = default;
+        // Все вершины в одной компоненте
+        explicit RoutesInternalData(size_t vertex_count)
+            : RoutesInternalData(std::vector<uint32_t>(vertex_count, 0)) {
+        }
+        // components[v] - номер компоненты вершины v, номера идут подряд с нуля
+        explicit RoutesInternalData(std::vector<uint32_t> components)
+            : components_(std::move(components))
+            , indices_(components_.size()) {
+            const size_t component_count = components_.empty()
+                ? 0
+                : *std::max_element(components_.begin(), components_.end()) + size_t{1};
+
+            vertices_begin_.assign(component_count + 1, 0);
+            for (const uint32_t component : components_) {
+                ++vertices_begin_[component + 1];
+            }
+            std::partial_sum(vertices_begin_.begin(), vertices_begin_.end(), vertices_begin_.begin());
+
+            vertices_.resize(components_.size());
+            std::vector<size_t> sizes(component_count, 0);
+            for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+                const uint32_t component = components_[vertex];
+                indices_[vertex] = static_cast<uint32_t>(sizes[component]);
+                vertices_[vertices_begin_[component] + sizes[component]++] = vertex;
+            }
+
+            tables_begin_.assign(component_count + 1, 0);
+            for (uint32_t component = 0; component < component_count; ++component) {
+                tables_begin_[component + 1] = tables_begin_[component] + sizes[component] * sizes[component];
+            }
+            weights_.assign(tables_begin_.back(), INFINITE_WEIGHT);
+            prev_edges_.assign(tables_begin_.back(), NO_EDGE);
+        }
+
+        size_t GetVertexCount() const {
+            return components_.size();
+        }
+        size_t GetComponentCount() const {
+            return vertices_begin_.size() - 1;
+        }
+        const std::vector<uint32_t>& GetComponents() const {
+            return components_;
+        }
+        uint32_t GetComponent(VertexId vertex) const {
+            return components_[vertex];
+        }
+        // Номер вершины внутри её компоненты
+        uint32_t GetIndex(VertexId vertex) const {
+            return indices_[vertex];
+        }
+        size_t GetComponentSize(uint32_t component) const {
+            return vertices_begin_[component + 1] - vertices_begin_[component];
+        }
+        const VertexId* GetComponentVertices(uint32_t component) const {
+            return vertices_.data() + vertices_begin_[component];
+        }
+
+        bool HasRoute(VertexId from, VertexId to) const {
+            return GetWeight(from, to) != INFINITE_WEIGHT;
+        }
+        Weight GetWeight(VertexId from, VertexId to) const {
+            return components_[from] == components_[to] ? GetWeights(from)[indices_[to]] : INFINITE_WEIGHT;
+        }
+        CompactEdgeId GetPrevEdge(VertexId from, VertexId to) const {
+            return components_[from] == components_[to] ? GetPrevEdges(from)[indices_[to]] : NO_EDGE;
+        }
+        // Вершины from и to должны лежать в одной компоненте
+        void Set(VertexId from, VertexId to, Weight weight, CompactEdgeId prev_edge) {
+            assert(components_[from] == components_[to]);
+            GetWeights(from)[indices_[to]] = weight;
+            GetPrevEdges(from)[indices_[to]] = prev_edge;
+        }
+
+        // Таблица компоненты размером GetComponentSize(component) в квадрате
+        Weight* GetComponentWeights(uint32_t component) {
+            return weights_.data() + tables_begin_[component];
+        }
+        const Weight* GetComponentWeights(uint32_t component) const {
+            return weights_.data() + tables_begin_[component];
+        }
+        CompactEdgeId* GetComponentPrevEdges(uint32_t component) {
+            return prev_edges_.data() + tables_begin_[component];
+        }
+        const CompactEdgeId* GetComponentPrevEdges(uint32_t component) const {
+            return prev_edges_.data() + tables_begin_[component];
+        }
+
+        // Строка from, индексируемая номерами вершин внутри компоненты
+        Weight* GetWeights(VertexId from) {
+            return GetComponentWeights(components_[from]) + GetRowOffset(from);
+        }
+        const Weight* GetWeights(VertexId from) const {
+            return GetComponentWeights(components_[from]) + GetRowOffset(from);
+        }
+        CompactEdgeId* GetPrevEdges(VertexId from) {
+            return GetComponentPrevEdges(components_[from]) + GetRowOffset(from);
+        }
+        const CompactEdgeId* GetPrevEdges(VertexId from) const {
+            return GetComponentPrevEdges(components_[from]) + GetRowOffset(from);
+        }
+
+        // Переносит маршруты в разбиение components, каждая компонента которого
+        // объединяет прежние. Добавленные в конец вершины остаются без маршрутов
+        void Regroup(std::vector<uint32_t> components) {
+            RoutesInternalData regrouped(std::move(components));
+            for (uint32_t component = 0; component < GetComponentCount(); ++component) {
+                const size_t size = GetComponentSize(component);
+                const VertexId* vertices = GetComponentVertices(component);
+                for (size_t from_idx = 0; from_idx < size; ++from_idx) {
+                    const Weight* weights = GetWeights(vertices[from_idx]);
+                    const CompactEdgeId* prev_edges = GetPrevEdges(vertices[from_idx]);
+                    for (size_t to_idx = 0; to_idx < size; ++to_idx) {
+                        regrouped.Set(vertices[from_idx], vertices[to_idx], weights[to_idx], prev_edges[to_idx]);
+                    }
+                }
+            }
+            *this = std::move(regrouped);
+        }
+
+    private:
+        size_t GetRowOffset(VertexId from) const {
+            return indices_[from] * GetComponentSize(components_[from]);
+        }
+
+        std::vector<uint32_t> components_;
+        std::vector<uint32_t> indices_;
+        // Вершины компоненты c - vertices_[vertices_begin_[c]..vertices_begin_[c + 1])
+        std::vector<size_t> vertices_begin_{0};
+        std::vector<VertexId> vertices_;
+        std::vector<size_t> tables_begin_{0};
+        std::vector<Weight> weights_;
+        std::vector<CompactEdgeId> prev_edges_;
+    };
+
+    // thread_count задаёт число потоков построения таблицы, 0 - по числу ядер
+    explicit Router(const Graph& graph, size_t thread_count = 0);
+    // Восстанавливает маршрутизатор по ранее посчитанным данным о маршрутах
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
+    // Ребро графа, вес которого изменился. У добавленного ребра прежний вес
+    // бесконечный, удалённое ребро получает бесконечный вес
+    struct EdgeUpdate {
+        EdgeId edge_id;
+        Weight old_weight;
+    };
+
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Записывает рёбра маршрута в edges в прямом порядке и возвращает его вес.
+    // Память не выделяется, если ёмкости edges хватает
+    std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+    // Веса кратчайших путей из from во все вершины, бесконечные для недостижимых
+    std::vector<Weight> ComputeWeights(VertexId from) const;
+
+    const RoutesInternalData& GetRoutesInternalData() const;
+
+    // Приводит таблицу в соответствие с графом, в котором изменились веса рёбер
+    // updates и могли добавиться вершины. Сначала исправляются строки,
+    // кратчайшие пути которых проходили по подорожавшим рёбрам, затем
+    // подешевевшие рёбра по одному добавляются в таблицу
+    void UpdateEdges(const std::vector<EdgeUpdate>& updates);
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    static VertexId FindRoot(std::vector<VertexId>& parents, VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    }
+
+    // Рёбра бесконечного веса удалены и компоненты не связывают
+    template <typename EdgeType>
+    static void UniteByEdge(std::vector<VertexId>& parents, const EdgeType& edge) {
+        if (edge.weight == INFINITE_WEIGHT) {
+            return;
+        }
+        const VertexId from_root = FindRoot(parents, edge.from);
+        const VertexId to_root = FindRoot(parents, edge.to);
+        if (from_root != to_root) {
+            parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+    }
+
+    // Компоненты нумеруются по возрастанию их наименьших вершин
+    static std::vector<uint32_t> NumberComponents(std::vector<VertexId>& parents) {
+        constexpr uint32_t no_component = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> components(parents.size());
+        std::vector<uint32_t> root_components(parents.size(), no_component);
+        uint32_t component_count = 0;
+        for (VertexId vertex = 0; vertex < parents.size(); ++vertex) {
+            uint32_t& component = root_components[FindRoot(parents, vertex)];
+            if (component == no_component) {
+                component = component_count++;
+            }
+            components[vertex] = component;
+        }
+        return components;
+    }
+
+    static std::vector<uint32_t> ComputeComponents(const Graph& graph) {
+        std::vector<VertexId> parents(graph.GetVertexCount());
+        std::iota(parents.begin(), parents.end(), VertexId{0});
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            UniteByEdge(parents, graph.GetEdge(edge_id));
+        }
+        return NumberComponents(parents);
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            routes_internal_data_.Set(vertex, vertex, ZERO_WEIGHT, NO_EDGE);
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                if (routes_internal_data_.GetWeight(vertex, edge.to) > edge.weight) {
+                    routes_internal_data_.Set(vertex, edge.to, edge.weight, static_cast<CompactEdgeId>(edge_id));
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Строки таблицы компоненты при релаксации через вершину независимы: строка
+    // и столбец vertex_through на этом шаге не меняются, поэтому диапазоны строк
+    // можно обрабатывать параллельно, не меняя результата. Номера вершин здесь
+    // внутри компоненты
+    void RelaxComponentThroughVertex(uint32_t component, size_t size, size_t vertex_through,
+                                     size_t rows_begin, size_t rows_end) {
+        Weight* weights = routes_internal_data_.GetComponentWeights(component);
+        CompactEdgeId* prev_edges = routes_internal_data_.GetComponentPrevEdges(component);
+        const Weight* weights_through = weights + vertex_through * size;
+        const CompactEdgeId* prev_edges_through = prev_edges + vertex_through * size;
+
+        for (size_t vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
+            Weight* weights_from = weights + vertex_from * size;
+            CompactEdgeId* prev_edges_from = prev_edges + vertex_from * size;
+
+            const Weight weight_from = weights_from[vertex_through];
+            if (weight_from == INFINITE_WEIGHT) {
+                continue;
+            }
+            RelaxRow(
+                weights_through, prev_edges_through, weight_from, prev_edges_from[vertex_through],
+                weights_from, prev_edges_from, size
+            );
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    void RelaxComponent(uint32_t component, size_t thread_count) {
+        const size_t size = routes_internal_data_.GetComponentSize(component);
+        thread_count = std::min(parallel::GetThreadCount(thread_count), size / MIN_ROWS_PER_THREAD);
+
+        if (thread_count <= 1) {
+            for (size_t vertex_through = 0; vertex_through < size; ++vertex_through) {
+                RelaxComponentThroughVertex(component, size, vertex_through, 0, size);
+            }
+            return;
+        }
+
+        // Каждый поток обрабатывает свой блок строк, после каждой промежуточной
+        // вершины потоки дожидаются друг друга
+        parallel::Barrier barrier(thread_count);
+        auto relax_rows = [this, &barrier, component, size, thread_count](size_t thread_idx) {
+            const size_t rows_begin = size * thread_idx / thread_count;
+            const size_t rows_end = size * (thread_idx + 1) / thread_count;
+            for (size_t vertex_through = 0; vertex_through < size; ++vertex_through) {
+                RelaxComponentThroughVertex(component, size, vertex_through, rows_begin, rows_end);
+                barrier.Wait();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx) {
+            workers.emplace_back(relax_rows, thread_idx);
+        }
+        relax_rows(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void RelaxRoutesInternalData(size_t thread_count) {
+        for (uint32_t component = 0; component < routes_internal_data_.GetComponentCount(); ++component) {
+            RelaxComponent(component, thread_count);
+        }
+    }
+
+    // Данные для исправления строк таблицы после подорожания рёбер
+    struct RowRepairData {
+        std::vector<bool> increased;
+        // Подешевевшие рёбра до их добавления в таблицу берутся с прежним весом
+        std::unordered_map<EdgeId, Weight> old_weights;
+        std::vector<std::vector<EdgeId>> incoming_edges;
+        std::vector<uint8_t> states;
+        std::vector<size_t> path;
+        std::vector<size_t> dirty;
+        std::vector<std::pair<Weight, size_t>> heap;
+
+        Weight GetWeight(EdgeId edge_id, Weight weight) const {
+            if (!old_weights.empty()) {
+                if (auto it = old_weights.find(edge_id); it != old_weights.end()) {
+                    return it->second;
+                }
+            }
+            return weight;
+        }
+    };
+
+    // Пересчитывает в строке from только вершины, пути до которых проходили
+    // по подорожавшим рёбрам: сначала по входящим рёбрам из остальных вершин,
+    // затем поиском Дейкстры внутри этого поддерева. Рёбра конечного веса не
+    // выходят за компоненту строки, вершины нумеруются внутри неё
+    void RepairRow(VertexId from, RowRepairData& data) {
+        enum : uint8_t { UNKNOWN, CLEAN, DIRTY };
+
+        const RoutesInternalData& routes = routes_internal_data_;
+        const uint32_t component = routes.GetComponent(from);
+        const size_t size = routes.GetComponentSize(component);
+        const VertexId* vertices = routes.GetComponentVertices(component);
+        Weight* weights = routes_internal_data_.GetWeights(from);
+        CompactEdgeId* prev_edges = routes_internal_data_.GetPrevEdges(from);
+
+        data.states.assign(size, UNKNOWN);
+        data.states[routes.GetIndex(from)] = CLEAN;
+        data.dirty.clear();
+        for (size_t vertex = 0; vertex < size; ++vertex) {
+            if (data.states[vertex] != UNKNOWN || weights[vertex] == INFINITE_WEIGHT) {
+                continue;
+            }
+            uint8_t state = CLEAN;
+            data.path.clear();
+            for (size_t current = vertex; ; ) {
+                if (data.states[current] != UNKNOWN) {
+                    state = data.states[current];
+                    break;
+                }
+                data.path.push_back(current);
+                const CompactEdgeId edge_id = prev_edges[current];
+                if (data.increased[edge_id]) {
+                    state = DIRTY;
+                    break;
+                }
+                current = routes.GetIndex(graph_.GetEdge(edge_id).from);
+            }
+            for (const size_t path_vertex : data.path) {
+                data.states[path_vertex] = state;
+                if (state == DIRTY) {
+                    data.dirty.push_back(path_vertex);
+                }
+            }
+        }
+
+        for (const size_t vertex : data.dirty) {
+            weights[vertex] = INFINITE_WEIGHT;
+            prev_edges[vertex] = NO_EDGE;
+        }
+
+        data.heap.clear();
+        for (const size_t vertex : data.dirty) {
+            for (const EdgeId edge_id : data.incoming_edges[vertices[vertex]]) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight edge_weight = data.GetWeight(edge_id, edge.weight);
+                if (edge_weight == INFINITE_WEIGHT) {
+                    continue;
+                }
+                const size_t vertex_from = routes.GetIndex(edge.from);
+                if (data.states[vertex_from] == DIRTY || weights[vertex_from] == INFINITE_WEIGHT) {
+                    continue;
+                }
+                const Weight candidate_weight = weights[vertex_from] + edge_weight;
+                if (candidate_weight < weights[vertex]) {
+                    weights[vertex] = candidate_weight;
+                    prev_edges[vertex] = static_cast<CompactEdgeId>(edge_id);
+                }
+            }
+            if (weights[vertex] != INFINITE_WEIGHT) {
+                data.heap.emplace_back(weights[vertex], vertex);
+            }
+        }
+        std::make_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+
+        while (!data.heap.empty()) {
+            std::pop_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+            const auto [weight, vertex] = data.heap.back();
+            data.heap.pop_back();
+            if (weights[vertex] < weight) {
+                continue;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertices[vertex])) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight edge_weight = data.GetWeight(edge_id, edge.weight);
+                if (edge_weight == INFINITE_WEIGHT) {
+                    continue;
+                }
+                const size_t vertex_to = routes.GetIndex(edge.to);
+                if (data.states[vertex_to] != DIRTY) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + edge_weight;
+                if (candidate_weight < weights[vertex_to]) {
+                    weights[vertex_to] = candidate_weight;
+                    prev_edges[vertex_to] = static_cast<CompactEdgeId>(edge_id);
+                    data.heap.emplace_back(candidate_weight, vertex_to);
+                    std::push_heap(data.heap.begin(), data.heap.end(), std::greater<>{});
+                }
+            }
+        }
+    }
+
+    // Добавляет в точную таблицу ребро edge_id: пути a -> from -> to -> b
+    // заменяют прежние, если они короче. Строка from и столбец to при этом
+    // не меняются. Если ребро не сокращает путь a -> to, оно не сокращает
+    // и пути из a дальше, поэтому такие строки пропускаются; так же
+    // отбираются концы b по строке from. Все вершины лежат в компоненте ребра
+    void RelaxRoutesInternalDataThroughEdge(EdgeId edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (!(edge.weight < routes_internal_data_.GetWeight(edge.from, edge.to))) {
+            return;
+        }
+
+        const uint32_t component = routes_internal_data_.GetComponent(edge.from);
+        const size_t size = routes_internal_data_.GetComponentSize(component);
+        const size_t edge_from = routes_internal_data_.GetIndex(edge.from);
+        const size_t edge_to = routes_internal_data_.GetIndex(edge.to);
+        Weight* weights = routes_internal_data_.GetComponentWeights(component);
+        CompactEdgeId* prev_edges = routes_internal_data_.GetComponentPrevEdges(component);
+
+        const Weight* weights_through = weights + edge_to * size;
+        const CompactEdgeId* prev_edges_through = prev_edges + edge_to * size;
+
+        std::vector<size_t> targets;
+        const Weight* weights_source = weights + edge_from * size;
+        for (size_t vertex_to = 0; vertex_to < size; ++vertex_to) {
+            if (weights_through[vertex_to] != INFINITE_WEIGHT
+                && edge.weight + weights_through[vertex_to] < weights_source[vertex_to]) {
+                targets.push_back(vertex_to);
+            }
+        }
+
+        for (size_t vertex_from = 0; vertex_from < size; ++vertex_from) {
+            Weight* weights_from = weights + vertex_from * size;
+            CompactEdgeId* prev_edges_from = prev_edges + vertex_from * size;
+            const Weight weight_from = weights_from[edge_from];
+            if (weight_from == INFINITE_WEIGHT || !(weight_from + edge.weight < weights_from[edge_to])) {
+                continue;
+            }
+
+            for (const size_t vertex_to : targets) {
+                const Weight weight_to = weights_through[vertex_to];
+                const Weight candidate_weight = weight_from + edge.weight + weight_to;
+                if (candidate_weight < weights_from[vertex_to]) {
+                    weights_from[vertex_to] = candidate_weight;
+                    prev_edges_from[vertex_to] = prev_edges_through[vertex_to] != NO_EDGE
+                        ? prev_edges_through[vertex_to]
+                        : static_cast<CompactEdgeId>(edge_id);
                 }
             }
         }
     }
 
+    static constexpr size_t MIN_ROWS_PER_THREAD = 64;
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_(ComputeComponents(graph))
 {
     InitializeRoutesInternalData(graph);
+    RelaxRoutesInternalData(thread_count);
+}
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    if (routes_internal_data_.GetVertexCount() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Routes data doesn't match the graph");
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename Graph>
+const typename Router<Weight, Graph>::RoutesInternalData& Router<Weight, Graph>::GetRoutesInternalData() const {
+    return routes_internal_data_;
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo> Router<Weight, Graph>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = BuildRoute(from, to, edges);
+    if (!weight) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-    {
-        edges.push_back(*edge_id);
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+// Путь проходится от конца дважды: сначала считается число рёбер, затем
+// рёбра записываются с конца, поэтому разворачивать их не нужно
+template <typename Weight, typename Graph>
+std::optional<Weight> Router<Weight, Graph>::BuildRoute(VertexId from, VertexId to,
+                                                        std::vector<EdgeId>& edges) const {
+    const size_t vertex_count = routes_internal_data_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (!routes_internal_data_.HasRoute(from, to)) {
+        return std::nullopt;
+    }
+
+    const RoutesInternalData& routes = routes_internal_data_;
+    const CompactEdgeId* prev_edges = routes.GetPrevEdges(from);
+    const CompactEdgeId last_edge = prev_edges[routes.GetIndex(to)];
+    size_t edge_count = 0;
+    for (CompactEdgeId edge_id = last_edge; edge_id != NO_EDGE;
+         edge_id = prev_edges[routes.GetIndex(graph_.GetEdge(edge_id).from)]) {
+        ++edge_count;
+    }
+
+    edges.resize(edge_count);
+    for (CompactEdgeId edge_id = last_edge; edge_id != NO_EDGE;
+         edge_id = prev_edges[routes.GetIndex(graph_.GetEdge(edge_id).from)]) {
+        edges[--edge_count] = edge_id;
+    }
+
+    return routes_internal_data_.GetWeight(from, to);
+}
+
+template <typename Weight, typename Graph>
+void Router<Weight, Graph>::UpdateEdges(const std::vector<EdgeUpdate>& updates) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+
+    // Добавленные рёбра и вершины могут объединить компоненты
+    const size_t old_vertex_count = routes_internal_data_.GetVertexCount();
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<VertexId> parents(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        parents[vertex] = vertex < old_vertex_count
+            ? routes_internal_data_.GetComponentVertices(routes_internal_data_.GetComponent(vertex))[0]
+            : vertex;
+    }
+    for (const auto& [edge_id, old_weight] : updates) {
+        UniteByEdge(parents, graph_.GetEdge(edge_id));
+    }
+    std::vector<uint32_t> components = NumberComponents(parents);
+    if (components != routes_internal_data_.GetComponents()) {
+        routes_internal_data_.Regroup(std::move(components));
+        for (VertexId vertex = old_vertex_count; vertex < vertex_count; ++vertex) {
+            routes_internal_data_.Set(vertex, vertex, ZERO_WEIGHT, NO_EDGE);
+        }
     }
-    std::reverse(edges.begin(), edges.end());
 
-    return RouteInfo{weight, std::move(edges)};
+    RowRepairData data;
+    data.increased.assign(graph_.GetEdgeCount(), false);
+    std::vector<bool> stale_rows(vertex_count, false);
+    bool has_stale_rows = false;
+    for (const auto& [edge_id, old_weight] : updates) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        if (edge.weight < old_weight) {
+            data.old_weights.emplace(edge_id, old_weight);
+        } else if (old_weight < edge.weight) {
+            data.increased[edge_id] = true;
+            // Ребро лежит на кратчайшем пути строки, только если оно последнее
+            // на пути до своего конца
+            const uint32_t component = routes_internal_data_.GetComponent(edge.to);
+            const size_t size = routes_internal_data_.GetComponentSize(component);
+            const VertexId* vertices = routes_internal_data_.GetComponentVertices(component);
+            const CompactEdgeId* prev_edges = routes_internal_data_.GetComponentPrevEdges(component);
+            const size_t edge_to = routes_internal_data_.GetIndex(edge.to);
+            for (size_t vertex_from = 0; vertex_from < size; ++vertex_from) {
+                if (prev_edges[vertex_from * size + edge_to] == edge_id) {
+                    stale_rows[vertices[vertex_from]] = true;
+                    has_stale_rows = true;
+                }
+            }
+        }
+    }
+
+    if (has_stale_rows) {
+        data.incoming_edges.resize(vertex_count);
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            data.incoming_edges[graph_.GetEdge(edge_id).to].push_back(edge_id);
+        }
+        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            if (stale_rows[vertex_from]) {
+                RepairRow(vertex_from, data);
+            }
+        }
+    }
+    for (const auto& [edge_id, old_weight] : updates) {
+        if (data.old_weights.count(edge_id) != 0) {
+            RelaxRoutesInternalDataThroughEdge(edge_id);
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+std::vector<Weight> Router<Weight, Graph>::ComputeWeights(VertexId from) const {
+    const size_t vertex_count = routes_internal_data_.GetVertexCount();
+    if (from >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const RoutesInternalData& routes = routes_internal_data_;
+    const uint32_t component = routes.GetComponent(from);
+    const size_t size = routes.GetComponentSize(component);
+    const VertexId* vertices = routes.GetComponentVertices(component);
+    const Weight* weights = routes.GetWeights(from);
+
+    std::vector<Weight> result(vertex_count, INFINITE_WEIGHT);
+    for (size_t vertex_to = 0; vertex_to < size; ++vertex_to) {
+        result[vertices[vertex_to]] = weights[vertex_to];
+    }
+    return result;
 }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -1,13 +1,22 @@
 #include "serialization.h"
+#include <climits>
 #include <fstream>
+#include <stdexcept>
 
 namespace catalogue::serialization {
 
+// Сообщение protobuf не может быть больше 2 ГБ. Таблица маршрутов больше
+// этой границы в базу не пишется и строится заново при обработке запросов
+constexpr size_t MAX_ROUTE_TABLE_BYTES = size_t{1} << 30;
+// Наибольший размер записи таблицы: вес и номер ребра varint-ом не длиннее 5 байт
+constexpr size_t MAX_ROUTE_TABLE_CELL_BYTES = (router::IS_FIXED_POINT_WEIGHT ? 5 : 8) + 5;
+
 void SaveToFile(
     const std::filesystem::path& path,
     const TransportCatalogue& cat,
     const renderer::Settings& render_settings,
-    const domain::RoutingSettings& routing_settings
+    const domain::RoutingSettings& routing_settings,
+    const router::TransportRouter& router
 ) {
     std::ofstream out_file(path, std::ios::binary);
 
@@ -16,64 +25,66 @@ void SaveToFile(
     *proto_cat.mutable_routes_info() = CatToProto(cat);
     *proto_cat.mutable_render_settings() = RendererSettingsToProto(render_settings);
     *proto_cat.mutable_routing_settings() = RoutingSettingsToProto(routing_settings);
+    *proto_cat.mutable_router() = TransportRouterToProto(router, cat);
 
-    proto_cat.SerializeToOstream(&out_file);
+    if (proto_cat.ByteSizeLong() > static_cast<size_t>(INT_MAX)) {
+        throw std::length_error("The base is too large for a single protobuf message");
+    }
+    if (!proto_cat.SerializeToOstream(&out_file)) {
+        throw std::runtime_error("Failed to write the base file");
+    }
 }
 
-std::tuple<TransportCatalogue, renderer::Settings, domain::RoutingSettings> FromFile(const std::filesystem::path& path) {
+std::tuple<
+    TransportCatalogue,
+    renderer::Settings,
+    domain::RoutingSettings,
+    std::optional<router::TransportRouter::State>
+> FromFile(const std::filesystem::path& path, bool load_router) {
     std::ifstream in_file(path, std::ios::binary);
 
     proto_transport::TransportCatalogue proto_cat;
-    proto_cat.ParseFromIstream(&in_file);
+    if (!proto_cat.ParseFromIstream(&in_file)) {
+        throw std::runtime_error("Failed to read the base file");
+    }
+
+    TransportCatalogue cat = CatFromProto(proto_cat.routes_info());
+
+    // Имена в состоянии маршрутизатора ссылаются на остановки и автобусы
+    // справочника, адреса которых при перемещении справочника не меняются
+    std::optional<router::TransportRouter::State> router_state;
+    if (load_router && proto_cat.has_router()) {
+        router_state = TransportRouterFromProto(proto_cat.router(), cat);
+    }
 
     return {
-        CatFromProto(proto_cat.routes_info()),
+        std::move(cat),
         RendererSettingFromProto(proto_cat.render_settings()),
-        RoutingSettingsFromProto(proto_cat.routing_settings())
+        RoutingSettingsFromProto(proto_cat.routing_settings()),
+        std::move(router_state)
     };
 }
 
+// Номера остановок в базе совпадают с их номерами в справочнике
 proto_transport::RoutesInfo CatToProto(const TransportCatalogue& cat) {
     proto_transport::RoutesInfo proto_routes_info;
-    std::unordered_map<const Stop*, int32_t> stop_to_id;
-
-    const auto& stops = cat.GetStops();
 
-    int32_t id = 0;
-    for (const auto& s : stops) {
-        stop_to_id[&s] = id;
-        *proto_routes_info.add_stop() = StopToProto(s, id);
-        ++id;
+    for (const auto& s : cat.GetStops()) {
+        *proto_routes_info.add_stop() = StopToProto(s, static_cast<int32_t>(s.id));
     }
 
-    for (const auto& s_from : stops) {
-        for (const auto& s_to : stops) {
-            if (&s_from == &s_to) { continue; }
-
-            std::optional<double> meters = cat.GetRoadDistance(s_from.name, s_to.name);
-
-            if (!meters.has_value()) { continue; }
-
-            proto_transport::Distance proto_distance;
-            proto_distance.set_from(stop_to_id[&s_from]);
-            proto_distance.set_to(stop_to_id[&s_to]);
-            proto_distance.set_meters(*meters);
-
-            *proto_routes_info.add_distance() = proto_distance;
-        }
+    for (const auto& [from, to, meters] : cat.GetRoadDistances()) {
+        proto_transport::Distance* proto_distance = proto_routes_info.add_distance();
+        proto_distance->set_from(from);
+        proto_distance->set_to(to);
+        proto_distance->set_meters(meters);
     }
 
     for (const auto& b : cat.GetBuses()) {
-        proto_transport::Bus proto_bus;
-        proto_bus.set_name(b.name);
-        proto_bus.set_is_roundtrip(b.is_roundtrip);
-
-        for (const auto s_ptr : b.stops) {
-            id = stop_to_id[s_ptr];
-            proto_bus.add_stop(id);
-        }
-
-        *proto_routes_info.add_bus() = proto_bus;
+        proto_transport::Bus* proto_bus = proto_routes_info.add_bus();
+        proto_bus->set_name(std::string(b.name));
+        proto_bus->set_is_roundtrip(b.is_roundtrip);
+        proto_bus->mutable_stop()->Assign(b.stops.begin(), b.stops.end());
     }
 
     return proto_routes_info;
@@ -82,41 +93,36 @@ proto_transport::RoutesInfo CatToProto(const TransportCatalogue& cat) {
 TransportCatalogue CatFromProto(const proto_transport::RoutesInfo& proto_routes_info) {
     TransportCatalogue cat;
 
-    std::unordered_map<int32_t, std::string> id_to_stopname;
-    for (int i = 0; i < proto_routes_info.stop_size(); ++i) {
-        const proto_transport::Stop& proto_stop = proto_routes_info.stop(i);
-
-        cat.AddStop(StopFromProto(proto_stop));
-        id_to_stopname[proto_stop.id()] = proto_stop.name();
+    std::unordered_map<int32_t, StopId> proto_id_to_stop;
+    for (const auto& proto_stop : proto_routes_info.stop()) {
+        proto_id_to_stop[proto_stop.id()] = cat.AddStop(StopFromProto(proto_stop));
     }
 
-    for (int i = 0; i < proto_routes_info.distance_size(); ++i) {
-        const proto_transport::Distance& proto_distance = proto_routes_info.distance(i);
+    // Пишутся только заданные расстояния. Старые версии сохраняли каждую пару
+    // остановок в обоих направлениях, такие записи считаются заданными
+    for (const auto& proto_distance : proto_routes_info.distance()) {
         cat.SetRoadDistance(
-            id_to_stopname[proto_distance.from()],
-            id_to_stopname[proto_distance.to()],
+            proto_id_to_stop.at(proto_distance.from()),
+            proto_id_to_stop.at(proto_distance.to()),
             proto_distance.meters()
         );
     }
 
-    for (int i = 0; i < proto_routes_info.bus_size(); ++i) {
-        const proto_transport::Bus& proto_bus = proto_routes_info.bus(i);
-
-        std::vector<std::string> stops;
-        for (int j = 0; j < proto_bus.stop_size(); ++j) {
-            int id = proto_bus.stop(j);
-            stops.push_back(id_to_stopname[id]);
+    for (const auto& proto_bus : proto_routes_info.bus()) {
+        std::vector<StopId> stops;
+        stops.reserve(proto_bus.stop_size());
+        for (const int32_t id : proto_bus.stop()) {
+            stops.push_back(proto_id_to_stop.at(id));
         }
-
-        cat.AddBus(proto_bus.name(), stops, proto_bus.is_roundtrip());
+        cat.AddBus(proto_bus.name(), std::move(stops), proto_bus.is_roundtrip());
     }
 
-    return std::move(cat);
+    return cat;
 }
 
 proto_transport::Stop StopToProto(const Stop& s, int32_t id) {
     proto_transport::Stop proto_stop;
-    proto_stop.set_name(s.name);
+    proto_stop.set_name(std::string(s.name));
     proto_stop.set_id(id);
 
     proto_transport::Coordinates proto_coords;
@@ -136,16 +142,248 @@ proto_router::RoutingSettings RoutingSettingsToProto(const domain::RoutingSettin
     proto_router::RoutingSettings proto_routing_settings;
     proto_routing_settings.set_bus_wait_time(settings.bus_wait_time);
     proto_routing_settings.set_bus_velocity(settings.bus_velocity);
+    proto_routing_settings.set_router_type(static_cast<proto_router::RouterType>(settings.router_type));
+    proto_routing_settings.set_thread_count(settings.thread_count);
+    proto_routing_settings.set_graph_model(static_cast<proto_router::GraphModel>(settings.graph_model));
     return proto_routing_settings;
 }
 
 domain::RoutingSettings RoutingSettingsFromProto(const proto_router::RoutingSettings& proto_settings) {
     return {
          proto_settings.bus_wait_time(),
-         proto_settings.bus_velocity()
+         proto_settings.bus_velocity(),
+         static_cast<domain::RouterType>(proto_settings.router_type()),
+         static_cast<domain::GraphModel>(proto_settings.graph_model()),
+         proto_settings.thread_count()
     };
 }
 
+proto_router::TransportRouter TransportRouterToProto(
+    const router::TransportRouter& router,
+    const TransportCatalogue& cat
+) {
+    proto_router::TransportRouter proto_router;
+
+    const auto& graph = router.GetGraph();
+    const size_t vertex_count = graph.GetVertexCount();
+    proto_router.set_vertex_count(vertex_count);
+    proto_router.set_fixed_point_weight(router::IS_FIXED_POINT_WEIGHT);
+
+    for (graph::EdgeId id = 0; id < graph.GetEdgeCount(); ++id) {
+        const auto& edge = graph.GetEdge(id);
+        proto_router::Edge* proto_edge = proto_router.add_edge();
+        proto_edge->set_from(edge.from);
+        proto_edge->set_to(edge.to);
+        proto_edge->set_weight(edge.weight);
+    }
+
+    for (const auto& info : router.GetEdgesInfo()) {
+        proto_router::EdgeInfo* proto_info = proto_router.add_edge_info();
+        // Имена хранятся номерами остановок и автобусов справочника
+        proto_info->set_name_id(
+            info.span_count == 0 ? cat.FindStopId(info.name).value() : cat.FindBusId(info.name).value()
+        );
+        proto_info->set_span_count(info.span_count);
+        proto_info->set_time(info.time);
+    }
+
+    const auto* routes_internal_data = router.GetRoutesInternalData();
+    size_t table_size = 0;
+    if (routes_internal_data) {
+        for (uint32_t component = 0; component < routes_internal_data->GetComponentCount(); ++component) {
+            const size_t size = routes_internal_data->GetComponentSize(component);
+            table_size += size * size;
+        }
+    }
+
+    if (routes_internal_data && table_size <= MAX_ROUTE_TABLE_BYTES / MAX_ROUTE_TABLE_CELL_BYTES) {
+        using AllPairsRouter = router::TransportRouter::AllPairsRouter;
+
+        proto_router::RoutesInternalData* proto_routes = proto_router.mutable_routes_internal_data();
+        const auto& components = routes_internal_data->GetComponents();
+        proto_routes->mutable_component()->Assign(components.begin(), components.end());
+
+        if constexpr (router::IS_FIXED_POINT_WEIGHT) {
+            proto_routes->mutable_fixed_point_weight()->Reserve(table_size);
+        } else {
+            proto_routes->mutable_weight()->Reserve(table_size);
+        }
+        proto_routes->mutable_prev_edge()->Reserve(table_size);
+
+        for (uint32_t component = 0; component < routes_internal_data->GetComponentCount(); ++component) {
+            const size_t size = routes_internal_data->GetComponentSize(component);
+            const router::RouteWeight* weights = routes_internal_data->GetComponentWeights(component);
+            const AllPairsRouter::CompactEdgeId* prev_edges = routes_internal_data->GetComponentPrevEdges(component);
+            for (size_t idx = 0; idx < size * size; ++idx) {
+                if constexpr (router::IS_FIXED_POINT_WEIGHT) {
+                    proto_routes->add_fixed_point_weight(weights[idx]);
+                } else {
+                    proto_routes->add_weight(weights[idx]);
+                }
+                proto_routes->add_prev_edge(
+                    prev_edges[idx] == AllPairsRouter::NO_EDGE ? -1 : static_cast<int64_t>(prev_edges[idx])
+                );
+            }
+        }
+    }
+
+    if (const auto* contraction_hierarchy = router.GetContractionHierarchy()) {
+        proto_router::ContractionHierarchy* proto_ch = proto_router.mutable_contraction_hierarchy();
+        for (const uint32_t rank : contraction_hierarchy->ranks) {
+            proto_ch->add_rank(rank);
+        }
+        for (const auto& shortcut : contraction_hierarchy->shortcuts) {
+            proto_router::Shortcut* proto_shortcut = proto_ch->add_shortcut();
+            proto_shortcut->set_from(shortcut.from);
+            proto_shortcut->set_to(shortcut.to);
+            proto_shortcut->set_weight(shortcut.weight);
+            proto_shortcut->set_first(shortcut.first);
+            proto_shortcut->set_second(shortcut.second);
+        }
+    }
+
+    if (const auto* hub_labels = router.GetHubLabels()) {
+        using HubLabelRouter = router::TransportRouter::HubLabelRouter;
+
+        auto label_set_to_proto = [](const HubLabelRouter::LabelSet& labels, proto_router::LabelSet* proto_labels) {
+            proto_labels->mutable_offset()->Add(labels.offsets.begin(), labels.offsets.end());
+            proto_labels->mutable_hub()->Add(labels.hubs.begin(), labels.hubs.end());
+            proto_labels->mutable_weight()->Add(labels.weights.begin(), labels.weights.end());
+            proto_labels->mutable_edge()->Reserve(labels.edges.size());
+            for (const graph::EdgeId edge_id : labels.edges) {
+                proto_labels->add_edge(edge_id == HubLabelRouter::NO_EDGE ? -1 : static_cast<int64_t>(edge_id));
+            }
+        };
+        proto_router::HubLabels* proto_hub_labels = proto_router.mutable_hub_labels();
+        label_set_to_proto(hub_labels->forward, proto_hub_labels->mutable_forward());
+        label_set_to_proto(hub_labels->backward, proto_hub_labels->mutable_backward());
+    }
+
+    return proto_router;
+}
+
+router::TransportRouter::State TransportRouterFromProto(
+    const proto_router::TransportRouter& proto_router,
+    const TransportCatalogue& cat
+) {
+    const auto& stops = cat.GetStops();
+    const auto& buses = cat.GetBuses();
+    const size_t vertex_count = proto_router.vertex_count();
+
+    // Веса хранятся в единицах сборки, создавшей базу
+    if (proto_router.fixed_point_weight() != router::IS_FIXED_POINT_WEIGHT) {
+        throw std::invalid_argument("Route weight type doesn't match the base");
+    }
+
+    router::TransportRouter::State state{
+        router::TransportRouter::RouteGraph(vertex_count), {}, std::nullopt, std::nullopt, std::nullopt
+    };
+
+    for (const auto& proto_edge : proto_router.edge()) {
+        state.graph.AddEdge({
+            proto_edge.from(), proto_edge.to(), static_cast<router::RouteWeight>(proto_edge.weight())
+        });
+    }
+
+    state.edges_info.reserve(proto_router.edge_info_size());
+    for (const auto& proto_info : proto_router.edge_info()) {
+        std::string_view name = proto_info.span_count() == 0
+            ? std::string_view(stops.at(proto_info.name_id()).name)
+            : std::string_view(buses.at(proto_info.name_id()).name);
+        state.edges_info.push_back({
+            name, proto_info.span_count(), static_cast<router::RouteWeight>(proto_info.time())
+        });
+    }
+
+    if (proto_router.has_routes_internal_data()) {
+        const auto& proto_routes = proto_router.routes_internal_data();
+        auto get_weight = [&proto_routes](size_t idx) -> router::RouteWeight {
+            if constexpr (router::IS_FIXED_POINT_WEIGHT) {
+                return proto_routes.fixed_point_weight(idx);
+            } else {
+                return proto_routes.weight(idx);
+            }
+        };
+        // В базах без разбиения на компоненты все вершины в одной компоненте
+        std::vector<uint32_t> components(proto_routes.component().begin(), proto_routes.component().end());
+        if (components.empty()) {
+            components.assign(vertex_count, 0);
+        }
+        if (components.size() != vertex_count) {
+            throw std::invalid_argument("Invalid routes data size");
+        }
+
+        using AllPairsRouter = router::TransportRouter::AllPairsRouter;
+        auto& routes_internal_data = state.routes_internal_data.emplace(std::move(components));
+
+        size_t table_size = 0;
+        for (uint32_t component = 0; component < routes_internal_data.GetComponentCount(); ++component) {
+            const size_t size = routes_internal_data.GetComponentSize(component);
+            table_size += size * size;
+        }
+        const int weight_count = router::IS_FIXED_POINT_WEIGHT
+            ? proto_routes.fixed_point_weight_size()
+            : proto_routes.weight_size();
+        if (static_cast<size_t>(weight_count) != table_size || proto_routes.prev_edge_size() != weight_count) {
+            throw std::invalid_argument("Invalid routes data size");
+        }
+
+        size_t idx = 0;
+        for (uint32_t component = 0; component < routes_internal_data.GetComponentCount(); ++component) {
+            const size_t size = routes_internal_data.GetComponentSize(component);
+            router::RouteWeight* weights = routes_internal_data.GetComponentWeights(component);
+            AllPairsRouter::CompactEdgeId* prev_edges = routes_internal_data.GetComponentPrevEdges(component);
+            for (size_t cell = 0; cell < size * size; ++cell, ++idx) {
+                const int64_t prev_edge = proto_routes.prev_edge(idx);
+                weights[cell] = get_weight(idx);
+                prev_edges[cell] = prev_edge < 0
+                    ? AllPairsRouter::NO_EDGE
+                    : static_cast<AllPairsRouter::CompactEdgeId>(prev_edge);
+            }
+        }
+    }
+
+    if (proto_router.has_contraction_hierarchy()) {
+        const auto& proto_ch = proto_router.contraction_hierarchy();
+        auto& contraction_hierarchy = state.contraction_hierarchy.emplace();
+
+        contraction_hierarchy.ranks.assign(proto_ch.rank().begin(), proto_ch.rank().end());
+        contraction_hierarchy.shortcuts.reserve(proto_ch.shortcut_size());
+        for (const auto& proto_shortcut : proto_ch.shortcut()) {
+            contraction_hierarchy.shortcuts.push_back({
+                proto_shortcut.from(),
+                proto_shortcut.to(),
+                static_cast<router::RouteWeight>(proto_shortcut.weight()),
+                proto_shortcut.first(),
+                proto_shortcut.second()
+            });
+        }
+    }
+
+    if (proto_router.has_hub_labels()) {
+        using HubLabelRouter = router::TransportRouter::HubLabelRouter;
+
+        auto label_set_from_proto = [](const proto_router::LabelSet& proto_labels) {
+            HubLabelRouter::LabelSet labels;
+            labels.offsets.assign(proto_labels.offset().begin(), proto_labels.offset().end());
+            labels.hubs.assign(proto_labels.hub().begin(), proto_labels.hub().end());
+            labels.weights.assign(proto_labels.weight().begin(), proto_labels.weight().end());
+            labels.edges.reserve(proto_labels.edge_size());
+            for (const int64_t edge_id : proto_labels.edge()) {
+                labels.edges.push_back(edge_id < 0 ? HubLabelRouter::NO_EDGE : static_cast<graph::EdgeId>(edge_id));
+            }
+            return labels;
+        };
+        const auto& proto_hub_labels = proto_router.hub_labels();
+        state.hub_labels = HubLabelRouter::Data{
+            label_set_from_proto(proto_hub_labels.forward()),
+            label_set_from_proto(proto_hub_labels.backward())
+        };
+    }
+
+    return state;
+}
+
 proto_render::Color ColorToProto::operator()(std::monostate) {
     proto_render::Color proto_color;
     proto_color.set_type(proto_render::Color_TYPE::Color_TYPE_NONE);
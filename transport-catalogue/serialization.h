@@ -3,6 +3,7 @@
 #include "svg.h"
 #include "transport_catalogue.h"
 #include "map_renderer.h"
+#include "transport_router.h"
 #include "domain.h"
 
 #include <transport_catalogue.pb.h>
@@ -13,10 +14,16 @@ void SaveToFile(
     const std::filesystem::path& path,
     const TransportCatalogue& cat,
     const renderer::Settings& render_settings,
-    const domain::RoutingSettings& routing_settings
+    const domain::RoutingSettings& routing_settings,
+    const router::TransportRouter& router
 );
 
-std::tuple<TransportCatalogue, renderer::Settings, domain::RoutingSettings> FromFile(const std::filesystem::path& path);
+std::tuple<
+    TransportCatalogue,
+    renderer::Settings,
+    domain::RoutingSettings,
+    std::optional<router::TransportRouter::State>
+> FromFile(const std::filesystem::path& path, bool load_router = true);
 
 proto_transport::RoutesInfo CatToProto(const TransportCatalogue& cat);
 TransportCatalogue CatFromProto(const proto_transport::RoutesInfo& proto_routes_info);
@@ -27,6 +34,15 @@ domain::Stop StopFromProto(const proto_transport::Stop& proto_stop);
 proto_router::RoutingSettings RoutingSettingsToProto(const domain::RoutingSettings& settings);
 domain::RoutingSettings RoutingSettingsFromProto(const proto_router::RoutingSettings& proto_settings);
 
+proto_router::TransportRouter TransportRouterToProto(
+    const router::TransportRouter& router,
+    const TransportCatalogue& cat
+);
+router::TransportRouter::State TransportRouterFromProto(
+    const proto_router::TransportRouter& proto_router,
+    const TransportCatalogue& cat
+);
+
 struct ColorToProto {
     proto_render::Color operator()(std::monostate);
     proto_render::Color operator()(const std::string& str);
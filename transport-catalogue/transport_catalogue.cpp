@@ -1,115 +1,270 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+
 namespace catalogue {
 
-void TransportCatalogue::AddStop(const Stop& stop) {
-    stops_.push_back(std::move(stop));
-    stopname_to_stop_[stops_.back().name] = &stops_.back();
-    stop_to_buses_[&stops_.back()] = {};
+StopId TransportCatalogue::AddStop(const Stop& stop) {
+    const StopId id = static_cast<StopId>(stops_.size());
+    const NameArena::NameId name_id = stop_names_.Intern(stop.name);
+    stops_.push_back({stop_names_.GetName(name_id), stop.coords, id});
+    latitudes_.push_back(stop.coords.lat);
+    longitudes_.push_back(stop.coords.lng);
+    stop_name_to_id_.resize(stop_names_.GetSize());
+    stop_name_to_id_[name_id] = id;
+    stop_to_buses_.emplace_back();
+    return id;
+}
+
+const Stop* TransportCatalogue::UpdateStop(const Stop& stop) {
+    const auto id = FindStopId(stop.name);
+    if (!id) {
+        return &stops_[AddStop(stop)];
+    }
+
+    Stop& target = stops_[*id];
+    if (target.coords == stop.coords) {
+        return &target;
+    }
+    target.coords = stop.coords;
+    latitudes_[*id] = stop.coords.lat;
+    longitudes_[*id] = stop.coords.lng;
+
+    // Расстояния по прямой от остановки устарели, извилистость её автобусов тоже
+    for (const std::string_view bus_name : stop_to_buses_[*id]) {
+        const Bus& bus = buses_[*FindBusId(bus_name)];
+        for (size_t i = 0; i + 1 < bus.stops.size(); ++i) {
+            if (bus.stops[i] == *id || bus.stops[i + 1] == *id) {
+                geo_distances_.Set(bus.stops[i], bus.stops[i + 1], geo::ComputeDistance(
+                    GetStopCoordinates(bus.stops[i]),
+                    GetStopCoordinates(bus.stops[i + 1])
+                ));
+            }
+        }
+        bus_infos_[bus.id] = ComputeBusInfo(bus);
+    }
+
+    return &target;
 }
 
 void TransportCatalogue::SetRoadDistance(
-    const std::string& from,
-    const std::string& to,
+    std::string_view from,
+    std::string_view to,
     double distance
 ) {
-    road_distances_[
-        {stopname_to_stop_[from], stopname_to_stop_[to]}
-    ] = distance;
+    const auto from_id = FindStopId(from);
+    const auto to_id = FindStopId(to);
+    if (from_id && to_id) {
+        SetRoadDistance(*from_id, *to_id, distance);
+    }
+}
+
+void TransportCatalogue::SetRoadDistance(StopId from, StopId to, double distance) {
+    road_distances_.Set(from, to, distance);
+
+    // При обновлении базы расстояние может поменять длину уже добавленных маршрутов
+    for (const std::string_view bus_name : stop_to_buses_[from]) {
+        const BusId id = *FindBusId(bus_name);
+        bus_infos_[id] = ComputeBusInfo(buses_[id]);
+    }
 }
 
 std::optional<double> TransportCatalogue::GetRoadDistance(
-    const std::string& from,
-    const std::string& to
+    std::string_view from,
+    std::string_view to
 ) const {
-    if (stopname_to_stop_.count(from) == 0 || stopname_to_stop_.count(to) == 0) {
+    const auto from_id = FindStopId(from);
+    const auto to_id = FindStopId(to);
+    if (!from_id || !to_id) {
         return std::nullopt;
     }
-    auto p = std::pair{stopname_to_stop_.at(from), stopname_to_stop_.at(to)};
-    if (road_distances_.count(p) == 1) {
-        return road_distances_.at(p);
-    } else if (road_distances_.count({p.second, p.first})){
-        return road_distances_.at({p.second, p.first});
+    return GetRoadDistance(*from_id, *to_id);
+}
+
+std::optional<double> TransportCatalogue::GetRoadDistance(const Stop* from, const Stop* to) const {
+    return GetRoadDistance(from->id, to->id);
+}
+
+std::optional<double> TransportCatalogue::GetRoadDistance(StopId from, StopId to) const {
+    return road_distances_.Get(from, to);
+}
+
+std::vector<std::tuple<StopId, StopId, double>> TransportCatalogue::GetRoadDistances() const {
+    return road_distances_.GetEntries();
+}
+
+BusId TransportCatalogue::AddBus(
+    std::string_view name,
+    const std::vector<std::string_view>& stops,
+    bool is_roundtrip
+) {
+    return AddBus(name, FindStopIds(stops), is_roundtrip);
+}
+
+BusId TransportCatalogue::AddBus(
+    std::string_view name,
+    std::vector<StopId> stops,
+    bool is_roundtrip
+) {
+    const BusId id = static_cast<BusId>(buses_.size());
+    const NameArena::NameId name_id = bus_names_.Intern(name);
+    buses_.push_back({bus_names_.GetName(name_id), std::move(stops), is_roundtrip, id});
+
+    for (const StopId stop : buses_.back().stops) {
+        stop_to_buses_[stop].insert(buses_.back().name);
     }
-    return std::nullopt;
+
+    bus_name_to_id_.resize(bus_names_.GetSize());
+    bus_name_to_id_[name_id] = id;
+    bus_infos_.push_back(ComputeBusInfo(buses_.back()));
+    return id;
 }
 
-void TransportCatalogue::AddBus(
-    const std::string& name,
-    const std::vector<std::string>& stops,
+const Bus* TransportCatalogue::UpdateBus(
+    std::string_view name,
+    const std::vector<std::string_view>& stops,
     bool is_roundtrip
 ) {
-    Bus bus;
-    bus.name = std::move(name);
+    const auto id = FindBusId(name);
+    if (!id) {
+        return &buses_[AddBus(name, stops, is_roundtrip)];
+    }
+
+    Bus& bus = buses_[*id];
+    for (const StopId stop : bus.stops) {
+        stop_to_buses_[stop].erase(bus.name);
+    }
+
     bus.is_roundtrip = is_roundtrip;
+    bus.stops = FindStopIds(stops);
 
-    for (const auto& stop_name : stops) {
-        bus.stops.push_back(stopname_to_stop_[stop_name]);
+    for (const StopId stop : bus.stops) {
+        stop_to_buses_[stop].insert(bus.name);
     }
 
-    buses_.push_back(std::move(bus));
+    bus_infos_[*id] = ComputeBusInfo(bus);
+    return &bus;
+}
 
-    for (const auto& stop : buses_.back().stops) {
-        stop_to_buses_[stop].insert(buses_.back().name);
+const Stop* TransportCatalogue::FindStop(std::string_view name) const {
+    if (const auto id = FindStopId(name)) {
+        return &stops_[*id];
+    }
+    return nullptr;
+}
+
+std::optional<StopId> TransportCatalogue::FindStopId(std::string_view name) const {
+    if (const auto name_id = stop_names_.Find(name)) {
+        return stop_name_to_id_[*name_id];
+    }
+    return std::nullopt;
+}
+
+std::optional<BusId> TransportCatalogue::FindBusId(std::string_view name) const {
+    if (const auto name_id = bus_names_.Find(name)) {
+        return bus_name_to_id_[*name_id];
     }
+    return std::nullopt;
+}
+
+size_t TransportCatalogue::GetStopCount() const {
+    return stops_.size();
+}
+
+size_t TransportCatalogue::GetBusCount() const {
+    return buses_.size();
+}
+
+const Stop& TransportCatalogue::GetStop(StopId id) const {
+    return stops_[id];
+}
+
+const Bus& TransportCatalogue::GetBus(BusId id) const {
+    return buses_[id];
+}
+
+geo::Coordinates TransportCatalogue::GetStopCoordinates(StopId id) const {
+    return {latitudes_[id], longitudes_[id]};
+}
+
+const std::vector<double>& TransportCatalogue::GetLatitudes() const {
+    return latitudes_;
+}
 
-    busname_to_bus_[buses_.back().name] = &buses_.back();
+const std::vector<double>& TransportCatalogue::GetLongitudes() const {
+    return longitudes_;
 }
 
-std::optional<BusInfo> TransportCatalogue::GetBusInfo(const std::string& name) {
-    if (busname_to_bus_.count(name) == 0) {
+std::optional<BusInfo> TransportCatalogue::GetBusInfo(std::string_view name) const {
+    const auto id = FindBusId(name);
+    if (!id) {
         return std::nullopt;
     }
+    return bus_infos_[*id];
+}
 
-    const Bus* bus = busname_to_bus_.at(name);
+const BusInfo& TransportCatalogue::GetBusInfo(BusId id) const {
+    return bus_infos_[id];
+}
 
-    size_t unique_stops = std::set(bus->stops.begin(), bus->stops.end()).size();
-    double road_length = CalcRoadRouteLength(bus->stops);
-    double curvature = road_length / CalcGeoRouteLength(bus->stops);
+const std::set<std::string_view>* TransportCatalogue::GetBusesByStop(std::string_view name) const {
+    const auto id = FindStopId(name);
+    if (!id) {
+        return nullptr;
+    }
+    return &stop_to_buses_[*id];
+}
 
-    return BusInfo{
-        bus->stops.size(),
-        unique_stops,
-        road_length,
-        curvature
-    };
+const std::set<std::string_view>& TransportCatalogue::GetBusesByStop(StopId id) const {
+    return stop_to_buses_[id];
 }
 
-std::optional<std::set<std::string_view>> TransportCatalogue::GetBusesByStop(const std::string& name) const {
-    if (stopname_to_stop_.count(name) == 0) {
-        return std::nullopt;
+std::vector<StopId> TransportCatalogue::FindStopIds(const std::vector<std::string_view>& stops) const {
+    std::vector<StopId> ids;
+    ids.reserve(stops.size());
+    for (const std::string_view stop_name : stops) {
+        ids.push_back(FindStopId(stop_name).value());
     }
+    return ids;
+}
 
-    return stop_to_buses_.at(stopname_to_stop_.at(name));
+BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) {
+    std::vector<StopId> unique_stops = bus.stops;
+    std::sort(unique_stops.begin(), unique_stops.end());
+    unique_stops.erase(std::unique(unique_stops.begin(), unique_stops.end()), unique_stops.end());
+
+    const double road_length = CalcRoadRouteLength(bus.stops);
+    const double curvature = road_length / CalcGeoRouteLength(bus.stops);
+
+    return BusInfo{
+        static_cast<uint32_t>(bus.stops.size()),
+        static_cast<uint32_t>(unique_stops.size()),
+        road_length,
+        curvature
+    };
 }
 
-double TransportCatalogue::CalcGeoRouteLength(const std::vector<const Stop*>& stops) {
+double TransportCatalogue::CalcGeoRouteLength(const std::vector<StopId>& stops) {
     double result = 0;
-    for (size_t i = 0; i < stops.size() - 1; ++i) {
-        auto stop_pair = std::pair{stops[i], stops[i+1]};
-
-        if (geo_distances_.count(stop_pair) == 0) {
-            geo_distances_[stop_pair] = geo::ComputeDistance(
-                {stops[i]->coords},
-                {stops[i+1]->coords}
-            );
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        if (const double* distance = geo_distances_.Find(stops[i], stops[i+1])) {
+            result += *distance;
+            continue;
         }
-        result += geo_distances_.at(stop_pair);
+        const double distance = geo::ComputeDistance(
+            GetStopCoordinates(stops[i]),
+            GetStopCoordinates(stops[i+1])
+        );
+        geo_distances_.Set(stops[i], stops[i+1], distance);
+        result += distance;
     }
     return result;
 }
 
-double TransportCatalogue::CalcRoadRouteLength(const std::vector<const Stop*>& stops) const {
+double TransportCatalogue::CalcRoadRouteLength(const std::vector<StopId>& stops) const {
     double result = 0;
-    for (size_t i = 0; i < stops.size() - 1; ++i) {
-        auto stop_pair = std::pair{stops[i], stops[i+1]};
-
-        if (road_distances_.count(stop_pair) != 0) {
-            result += road_distances_.at(stop_pair);
-        } else {
-            result += road_distances_.at({stop_pair.second, stop_pair.first});
-        }
-
+    for (size_t i = 0; i + 1 < stops.size(); ++i) {
+        result += road_distances_.Get(stops[i], stops[i+1]).value();
     }
     return result;
 }
@@ -122,4 +277,4 @@ const std::deque<Bus>& TransportCatalogue::GetBuses() const {
     return buses_;
 }
 
-}
\ No newline at end of file
+}
@@ -4,72 +4,117 @@
 #include <unordered_set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <vector>
 #include <utility>
 #include <set>
 #include <optional>
 
+#include "distance_index.h"
 #include "domain.h"
+#include "name_arena.h"
 
 namespace catalogue {
 
 using domain::Stop;
 using domain::Bus;
+using domain::StopId;
+using domain::BusId;
 
 struct BusInfo {
-    size_t stop_count;
-    size_t unique_stops;
+    uint32_t stop_count;
+    uint32_t unique_stops;
     double road_length;
     double curvature;
 };
 
-struct StopPairHash {
-    size_t operator()(const std::pair<const Stop*, const Stop*>& stop_pair) const {
-        return hasher_(stop_pair.first) + 37 * hasher_(stop_pair.second);
-    }
-
-private:
-    std::hash<const Stop*> hasher_;
-};
-
+// Остановки и автобусы нумеруются подряд с нуля в порядке добавления.
+// Координаты остановок хранятся отдельными массивами широт и долгот,
+// остановки автобусов и расстояния - номерами остановок
 class TransportCatalogue {
 public:
     TransportCatalogue() {}
 
-    void AddStop(const Stop& stop);
+    StopId AddStop(const Stop& stop);
+    // Меняет координаты остановки или добавляет её, если такой ещё нет
+    const Stop* UpdateStop(const Stop& stop);
 
     void SetRoadDistance(
-        const std::string& from,
-        const std::string& to,
+        std::string_view from,
+        std::string_view to,
         double distance
     );
+    void SetRoadDistance(StopId from, StopId to, double distance);
 
-    std::optional<double> GetRoadDistance(const std::string& from, const std::string& to) const;
+    std::optional<double> GetRoadDistance(std::string_view from, std::string_view to) const;
+    std::optional<double> GetRoadDistance(const Stop* from, const Stop* to) const;
+    std::optional<double> GetRoadDistance(StopId from, StopId to) const;
+    // Заданные расстояния (from, to, метры) в порядке номеров остановок
+    std::vector<std::tuple<StopId, StopId, double>> GetRoadDistances() const;
 
-    void AddBus(
-        const std::string& name,
-        const std::vector<std::string>& stops,
+    BusId AddBus(
+        std::string_view name,
+        const std::vector<std::string_view>& stops,
+        bool is_roundtrip
+    );
+    BusId AddBus(
+        std::string_view name,
+        std::vector<StopId> stops,
+        bool is_roundtrip
+    );
+    // Меняет остановки автобуса или добавляет его, если такого ещё нет
+    const Bus* UpdateBus(
+        std::string_view name,
+        const std::vector<std::string_view>& stops,
         bool is_roundtrip
     );
 
+    const Stop* FindStop(std::string_view name) const;
+    std::optional<StopId> FindStopId(std::string_view name) const;
+    std::optional<BusId> FindBusId(std::string_view name) const;
+
+    size_t GetStopCount() const;
+    size_t GetBusCount() const;
+    const Stop& GetStop(StopId id) const;
+    const Bus& GetBus(BusId id) const;
+    geo::Coordinates GetStopCoordinates(StopId id) const;
+    const std::vector<double>& GetLatitudes() const;
+    const std::vector<double>& GetLongitudes() const;
+
     const std::deque<Stop>& GetStops() const;
     const std::deque<Bus>& GetBuses() const;
 
-    std::optional<BusInfo> GetBusInfo(const std::string& name);
+    // Статистика считается при добавлении автобуса и при изменении
+    // расстояний на его маршруте, запрос только читает готовое значение
+    std::optional<BusInfo> GetBusInfo(std::string_view name) const;
+    const BusInfo& GetBusInfo(BusId id) const;
 
-    std::optional<std::set<std::string_view>> GetBusesByStop(const std::string& name) const;
+    // Названия автобусов через остановку, nullptr - такой остановки нет
+    const std::set<std::string_view>* GetBusesByStop(std::string_view name) const;
+    const std::set<std::string_view>& GetBusesByStop(StopId id) const;
 
 private:
+    // Номер элемента в деке совпадает с его id
     std::deque<Stop> stops_;
     std::deque<Bus> buses_;
-    std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-    std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
-    std::unordered_map<const Stop*, std::set<std::string_view>> stop_to_buses_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, double, StopPairHash> geo_distances_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, double, StopPairHash> road_distances_;
-
-    double CalcGeoRouteLength(const std::vector<const Stop*>& stops);
-    double CalcRoadRouteLength(const std::vector<const Stop*>& stops) const;
+    std::vector<double> latitudes_;
+    std::vector<double> longitudes_;
+    // Имена остановок и автобусов, в Stop::name и Bus::name ссылки на них.
+    // Номер имени в хранилище переводится в id массивами ниже
+    NameArena stop_names_;
+    NameArena bus_names_;
+    std::vector<StopId> stop_name_to_id_;
+    std::vector<BusId> bus_name_to_id_;
+    std::vector<std::set<std::string_view>> stop_to_buses_;
+    std::vector<BusInfo> bus_infos_;
+    // Кэш расстояний по прямой между соседними остановками автобусов
+    DistanceIndex geo_distances_;
+    DistanceIndex road_distances_;
+
+    std::vector<StopId> FindStopIds(const std::vector<std::string_view>& stops) const;
+    BusInfo ComputeBusInfo(const Bus& bus);
+    double CalcGeoRouteLength(const std::vector<StopId>& stops);
+    double CalcRoadRouteLength(const std::vector<StopId>& stops) const;
 };
 
-}
\ No newline at end of file
+}
@@ -1,98 +1,752 @@
 #include "transport_router.h"
 
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
+
 namespace catalogue::router {
 
+namespace {
+
+// RAPTOR считает время в минутах
+RouteWeight RaptorTimeToWeight(double time) {
+    return time == std::numeric_limits<double>::infinity() ? INFINITE_ROUTE_WEIGHT : MinutesToWeight(time);
+}
+
+}
 
 TransportRouter::TransportRouter(
     const std::vector<const Stop*>& stops,
     const std::vector<const Bus*>& buses,
     const TransportCatalogue& cat,
-    domain::RoutingSettings settings
-)   : stops_(stops)
+    domain::RoutingSettings settings,
+    std::optional<State> state
+)   : edges_info_(state ? std::move(state->edges_info) : std::vector<EdgeInfo>{})
+    , stops_(stops)
     , buses_(buses)
     , cat_(cat)
     , settings_(std::move(settings))
-    , graph_(InitGraph())
-    , router_(graph_)
+    , stop_to_id_(IndexStops())
+    , graph_(state ? std::move(state->graph) : InitGraph())
+    , compact_graph_(InitCompactGraph())
+    , geo_bound_(InitGeoBound())
+    , reachability_router_(graph_)
+    , router_(InitRouter(state))
 {
 }
 
 std::optional<TransportRouter::RouteInfo> TransportRouter::BuildRoute(
-    const std::string& from, const std::string& to
+    std::string_view from, std::string_view to
 ) const {
-    auto FindStopByName = [this](const std::string& name) {
-        return std::find_if(stops_.begin(), stops_.end(),
-            [&name] (const Stop* s) { return s->name == name; }
-        );
+    RouteInfo result;
+    const auto total_time = BuildRoute(from, to, result.edges);
+    if (!total_time) {
+        return std::nullopt;
+    }
+    result.total_time = *total_time;
+    return result;
+}
+
+std::optional<RouteWeight> TransportRouter::BuildRoute(
+    std::string_view from, std::string_view to, std::vector<EdgeInfo>& edges
+) const {
+    const auto from_stop = cat_.FindStopId(from);
+    const auto to_stop = cat_.FindStopId(to);
+    if (!from_stop || !to_stop) {
+        return std::nullopt;
+    }
+    return BuildRoute(*from_stop, *to_stop, edges);
+}
+
+std::optional<RouteWeight> TransportRouter::BuildRoute(
+    StopId from, StopId to, std::vector<EdgeInfo>& edges
+) const {
+    const auto from_idx = FindStopId(from);
+    const auto to_idx = FindStopId(to);
+    if (!from_idx || !to_idx) {
+        return std::nullopt;
+    }
+
+    const size_t from_id = *from_idx;
+    const size_t to_id = *to_idx;
+
+    edges.clear();
+    return std::visit([this, from_id, to_id, &edges](const auto& router) -> std::optional<RouteWeight> {
+        using Engine = std::decay_t<decltype(router)>;
+        if constexpr (std::is_same_v<Engine, RaptorRouter>) {
+            return BuildRaptorRoute(router, from_id, to_id, edges);
+        } else if constexpr (std::is_same_v<Engine, AllPairsRouter>) {
+            // Буфер номеров рёбер у каждого потока свой и не освобождается между запросами
+            static thread_local std::vector<graph::EdgeId> edge_ids;
+            const auto total_time = router.BuildRoute(GetStopVertex(from_id), GetStopVertex(to_id), edge_ids);
+            if (!total_time) {
+                return std::nullopt;
+            }
+            for (const auto edge_id : edge_ids) {
+                AppendEdgeInfo(edge_id, edges);
+            }
+            return total_time;
+        } else {
+            std::optional<typename Engine::RouteInfo> route;
+            if constexpr (std::is_same_v<Engine, DijkstraRouter>) {
+                route = settings_.router_type == RouterType::A_STAR
+                    ? BuildGeoRoute(router, from_id, to_id)
+                    : router.BuildRoute(GetStopVertex(from_id), GetStopVertex(to_id));
+            } else {
+                route = router.BuildRoute(GetStopVertex(from_id), GetStopVertex(to_id));
+            }
+            if (!route) {
+                return std::nullopt;
+            }
+            for (const auto edge_id : route->edges) {
+                AppendEdgeInfo(edge_id, edges);
+            }
+            return route->weight;
+        }
+    }, router_);
+}
+
+std::optional<graph::VertexId> TransportRouter::FindStopVertex(std::string_view name) const {
+    const auto id = FindStopId(name);
+    if (!id) {
+        return std::nullopt;
+    }
+    return GetStopVertex(*id);
+}
+
+TransportRouter::TimeMatrix TransportRouter::BuildTimeMatrix(
+    const std::vector<std::string_view>& from, const std::vector<std::string_view>& to
+) const {
+    auto find_ids = [this](const std::vector<std::string_view>& names) {
+        std::vector<std::optional<size_t>> ids;
+        ids.reserve(names.size());
+        for (const auto& name : names) {
+            ids.push_back(FindStopId(name));
+        }
+        return ids;
     };
+    const std::vector<std::optional<size_t>> from_ids = find_ids(from);
+    const std::vector<std::optional<size_t>> to_ids = find_ids(to);
 
-    auto from_it = FindStopByName(from);
-    auto to_it = FindStopByName(to);
+    TimeMatrix times(from.size(), std::vector<std::optional<RouteWeight>>(to.size()));
+
+    auto fill_row = [this, &from_ids, &to_ids, &times](size_t row) {
+        if (!from_ids[row]) {
+            return;
+        }
+        const std::vector<RouteWeight> stop_times = ComputeTimes(*from_ids[row]);
+        for (size_t col = 0; col < to_ids.size(); ++col) {
+            if (to_ids[col] && stop_times[*to_ids[col]] != INFINITE_ROUTE_WEIGHT) {
+                times[row][col] = stop_times[*to_ids[col]];
+            }
+        }
+    };
+
+    const size_t thread_count = std::min(parallel::GetThreadCount(settings_.thread_count), from.size());
+    if (thread_count <= 1) {
+        for (size_t row = 0; row < from.size(); ++row) {
+            fill_row(row);
+        }
+        return times;
+    }
+
+    // Строки раздаются по одной: время поиска сильно зависит от остановки
+    std::atomic<size_t> next_row = 0;
+    auto fill_rows = [&next_row, &fill_row, row_count = from.size()] {
+        for (size_t row = next_row++; row < row_count; row = next_row++) {
+            fill_row(row);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t thread_idx = 1; thread_idx < thread_count; ++thread_idx) {
+        workers.emplace_back(fill_rows);
+    }
+    fill_rows();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return times;
+}
+
+std::optional<std::vector<TransportRouter::ReachedStop>> TransportRouter::BuildIsochrone(
+    std::string_view from, RouteWeight max_time
+) const {
+    const auto from_stop = cat_.FindStopId(from);
+    if (!from_stop) {
+        return std::nullopt;
+    }
+    return BuildIsochrone(*from_stop, max_time);
+}
 
-    if (from_it == stops_.end() || to_it == stops_.end()) {
+std::optional<std::vector<TransportRouter::ReachedStop>> TransportRouter::BuildIsochrone(
+    StopId from, RouteWeight max_time
+) const {
+    const auto from_idx = FindStopId(from);
+    if (!from_idx) {
         return std::nullopt;
     }
+    const size_t from_id = *from_idx;
+
+    std::vector<ReachedStop> reached;
 
-    size_t from_id = std::distance(stops_.begin(), from_it);
-    size_t to_id = std::distance(stops_.begin(), to_it);
+    // У RAPTOR нет графа, он отбрасывает прибытия позже max_time сам
+    if (const auto* raptor = std::get_if<RaptorRouter>(&router_)) {
+        const std::vector<double> times = raptor->ComputeTimes(from_id, WeightToMinutes(max_time));
+        for (size_t stop_id = 0; stop_id < times.size(); ++stop_id) {
+            const RouteWeight time = RaptorTimeToWeight(times[stop_id]);
+            if (time <= max_time) {
+                reached.push_back({stops_[stop_id]->name, time});
+            }
+        }
+        std::stable_sort(reached.begin(), reached.end(), [](const ReachedStop& lhs, const ReachedStop& rhs) {
+            return lhs.time < rhs.time;
+        });
+        return reached;
+    }
 
-    auto route = router_.BuildRoute(from_id * 2, to_id * 2);
+    for (const auto& [vertex, time] : reachability_router_.ComputeReachable(GetStopVertex(from_id), max_time)) {
+        const size_t stop_id = GetVertexStop(vertex);
+        if (GetStopVertex(stop_id) == vertex) {
+            reached.push_back({stops_[stop_id]->name, time});
+        }
+    }
+    return reached;
+}
+
+// Время в пути от остановки from_id до каждой остановки
+std::vector<RouteWeight> TransportRouter::ComputeTimes(size_t from_id) const {
+    return std::visit([this, from_id](const auto& router) {
+        std::vector<RouteWeight> times(stops_.size());
+        if constexpr (std::is_same_v<std::decay_t<decltype(router)>, RaptorRouter>) {
+            const std::vector<double> raptor_times = router.ComputeTimes(from_id);
+            std::transform(raptor_times.begin(), raptor_times.end(), times.begin(), RaptorTimeToWeight);
+            return times;
+        } else {
+            const std::vector<RouteWeight> weights = router.ComputeWeights(GetStopVertex(from_id));
+            for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+                times[stop_id] = weights[GetStopVertex(stop_id)];
+            }
+            return times;
+        }
+    }, router_);
+}
+
+std::optional<RouteWeight> TransportRouter::BuildRaptorRoute(
+    const RaptorRouter& router, size_t from_id, size_t to_id, std::vector<EdgeInfo>& edges
+) const {
+    auto route = router.BuildRoute(from_id, to_id);
     if (!route) {
         return std::nullopt;
     }
 
-    RouteInfo result;
-    result.total_time = route->weight;
+    // Время маршрута - сумма времён его частей: при целочисленных весах каждая
+    // часть округляется отдельно, и округлённое время всего маршрута с их суммой
+    // могло не совпасть
+    RouteWeight total_time{};
+    for (const auto& leg : route->legs) {
+        const auto& line = router.GetLine(leg.line_id);
+        const RouteWeight wait_time = MinutesToWeight(router.GetWaitTime());
+        const RouteWeight travel_time = MinutesToWeight(router.GetTravelTime(leg));
+        edges.push_back({stops_[line.stops[leg.board_pos]]->name, 0, wait_time});
+        edges.push_back({line.bus_name, leg.alight_pos - leg.board_pos, travel_time});
+        total_time += wait_time + travel_time;
+    }
+
+    return total_time;
+}
+
+std::optional<TransportRouter::DijkstraRouter::RouteInfo> TransportRouter::BuildGeoRoute(
+    const DijkstraRouter& router, size_t from_id, size_t to_id
+) const {
+    return router.BuildRoute(GetStopVertex(from_id), GetStopVertex(to_id), [this, to_id](graph::VertexId vertex) {
+        return static_cast<RouteWeight>(
+            geo_bound_.GetChordLength(GetVertexStop(vertex), to_id) * geo_bound_.inverse_speed
+        );
+    });
+}
+
+bool TransportRouter::HasWaitEdges() const {
+    return settings_.graph_model == GraphModel::WAIT_EDGES;
+}
+
+graph::VertexId TransportRouter::GetStopVertex(size_t stop_id) const {
+    return HasWaitEdges() ? stop_id * 2 : stop_id;
+}
 
-    for (const auto& edge_id : route->edges) {
-        result.edges.push_back(edges_info_[edge_id]);
+graph::VertexId TransportRouter::GetBoardingVertex(size_t stop_id) const {
+    return HasWaitEdges() ? stop_id * 2 + 1 : stop_id;
+}
+
+size_t TransportRouter::GetVertexStop(graph::VertexId vertex) const {
+    return HasWaitEdges() ? vertex / 2 : vertex;
+}
+
+// Ребро поездки модели с одной вершиной раскладывается на ожидание и поездку
+void TransportRouter::AppendEdgeInfo(graph::EdgeId edge_id, std::vector<EdgeInfo>& edges) const {
+    if (!HasWaitEdges()) {
+        edges.push_back({
+            stops_[graph_.GetEdge(edge_id).from]->name, 0, MinutesToWeight(settings_.bus_wait_time)
+        });
     }
+    edges.push_back(edges_info_[edge_id]);
+}
 
-    return result;
+std::optional<size_t> TransportRouter::FindStopId(std::string_view name) const {
+    const auto stop = cat_.FindStopId(name);
+    if (!stop) {
+        return std::nullopt;
+    }
+    return FindStopId(*stop);
 }
 
-void TransportRouter::AddToGraph(RouteGraph& g, const Bus* bus, size_t start_id, size_t end_id) {
-    auto FindStopId = [this](const Stop* s) {
-        return std::distance(stops_.begin(), std::find(stops_.begin(), stops_.end(), s));
-    };
+std::optional<size_t> TransportRouter::FindStopId(StopId stop) const {
+    if (stop >= stop_to_id_.size() || stop_to_id_[stop] == NO_STOP) {
+        return std::nullopt;
+    }
+    return stop_to_id_[stop];
+}
+
+std::vector<size_t> TransportRouter::IndexStops() const {
+    std::vector<size_t> stop_to_id(cat_.GetStopCount(), NO_STOP);
+    for (size_t i = 0; i < stops_.size(); ++i) {
+        stop_to_id[stops_[i]->id] = i;
+    }
+    return stop_to_id;
+}
+
+// distances[i] - расстояние по дорогам от начала маршрута до его i-й остановки
+void TransportRouter::AddBusEdges(
+    std::vector<BusEdge>& edges,
+    const Bus* bus,
+    const std::vector<double>& distances,
+    size_t start_id,
+    size_t end_id
+) const {
+    std::vector<size_t> stop_ids(end_id - start_id);
+    for (size_t i = start_id; i < end_id; ++i) {
+        stop_ids[i - start_id] = stop_to_id_[bus->stops[i]];
+    }
 
     for (size_t i = start_id; i < end_id - 1; ++i) {
-        size_t from_id = FindStopId(bus->stops[i]);
-        double current_distance = 0;
+        size_t from_id = stop_ids[i - start_id];
         for (size_t j = i + 1; j < end_id; ++j) {
-            size_t to_id = FindStopId(bus->stops[j]);
-            if (j == i + 1) {
-                current_distance += cat_.GetRoadDistance(bus->stops[i]->name, bus->stops[j]->name).value();
-            } else {
-                current_distance += cat_.GetRoadDistance(bus->stops[j-1]->name, bus->stops[j]->name).value();
-            }
-            double time = current_distance / settings_.bus_velocity;
-            g.AddEdge({from_id * 2 + 1, to_id * 2, time});
-            edges_info_.push_back({bus->name, j - i, time});
+            size_t to_id = stop_ids[j - start_id];
+            const RouteWeight time = MinutesToWeight((distances[j] - distances[i]) / settings_.bus_velocity);
+            const RouteWeight weight = HasWaitEdges() ? time : MinutesToWeight(settings_.bus_wait_time) + time;
+            edges.push_back({{GetBoardingVertex(from_id), GetStopVertex(to_id), weight}, j - i, time});
         }
     }
 }
 
+// Рёбра поездок автобуса без пересадок: кольцевой маршрут целиком,
+// некольцевой - отдельно в прямом и в обратном направлении
+std::vector<TransportRouter::BusEdge> TransportRouter::MakeBusEdges(const Bus* bus) const {
+    const std::vector<double> distances = ComputeDistances(bus);
+    std::vector<BusEdge> edges;
+
+    if (bus->is_roundtrip) {
+        AddBusEdges(edges, bus, distances, 0, bus->stops.size());
+    } else {
+        size_t end_stop_idx = bus->stops.size() / 2;
+        AddBusEdges(edges, bus, distances, 0, end_stop_idx + 1);
+        AddBusEdges(edges, bus, distances, end_stop_idx, bus->stops.size());
+    }
+
+    return edges;
+}
+
+// Расстояния по дорогам от начала маршрута автобуса до каждой его остановки
+std::vector<double> TransportRouter::ComputeDistances(const Bus* bus) const {
+    std::vector<double> distances(bus->stops.size(), 0);
+    for (size_t i = 1; i < bus->stops.size(); ++i) {
+        distances[i] = distances[i - 1] + cat_.GetRoadDistance(bus->stops[i - 1], bus->stops[i]).value();
+    }
+    return distances;
+}
+
 TransportRouter::RouteGraph TransportRouter::InitGraph() {
-    RouteGraph g(stops_.size() * 2);
+    if (settings_.router_type == RouterType::RAPTOR) {
+        return {};
+    }
 
-    for (size_t i = 0; i < stops_.size(); ++i) {
-        double time = static_cast<double>(settings_.bus_wait_time);
-        g.AddEdge({i * 2, i * 2 + 1, time});
-        edges_info_.push_back({stops_[i]->name, 0, time});
+    RouteGraph g(HasWaitEdges() ? stops_.size() * 2 : stops_.size());
+
+    if (HasWaitEdges()) {
+        for (size_t i = 0; i < stops_.size(); ++i) {
+            const RouteWeight time = MinutesToWeight(settings_.bus_wait_time);
+            g.AddEdge({GetStopVertex(i), GetBoardingVertex(i), time});
+            edges_info_.push_back({stops_[i]->name, 0, time});
+        }
+    }
+
+    for (const auto bus : buses_) {
+        for (const auto& [edge, span_count, time] : MakeBusEdges(bus)) {
+            g.AddEdge(edge);
+            edges_info_.push_back({bus->name, span_count, time});
+        }
+    }
+
+    return SortEdgesBySource(g);
+}
+
+// Перенумеровывает рёбра в порядке вершин-начал, чтобы рёбра, исходящие
+// из одной вершины, лежали в памяти подряд
+TransportRouter::RouteGraph TransportRouter::SortEdgesBySource(const RouteGraph& g) {
+    RouteGraph sorted(g.GetVertexCount());
+    std::vector<EdgeInfo> edges_info;
+    edges_info.reserve(edges_info_.size());
+
+    for (graph::VertexId vertex = 0; vertex < g.GetVertexCount(); ++vertex) {
+        for (const graph::EdgeId edge_id : g.GetIncidentEdges(vertex)) {
+            sorted.AddEdge(g.GetEdge(edge_id));
+            edges_info.push_back(edges_info_[edge_id]);
+        }
+    }
+
+    edges_info_ = std::move(edges_info);
+    return sorted;
+}
+
+TransportRouter::CompactRouteGraph TransportRouter::InitCompactGraph() const {
+    if (settings_.router_type != RouterType::DIJKSTRA
+        && settings_.router_type != RouterType::CONTRACTION_HIERARCHY
+        && settings_.router_type != RouterType::A_STAR
+        && settings_.router_type != RouterType::HUB_LABELS) {
+        return {};
+    }
+    return CompactRouteGraph(graph_);
+}
+
+double TransportRouter::GeoBound::GetChordLength(size_t from_id, size_t to_id) const {
+    const auto& from = points[from_id];
+    const auto& to = points[to_id];
+    const double dx = from[0] - to[0];
+    const double dy = from[1] - to[1];
+    const double dz = from[2] - to[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+TransportRouter::GeoBound TransportRouter::InitGeoBound() const {
+    if (settings_.router_type != RouterType::A_STAR) {
+        return {};
+    }
+
+    static const double dr = 3.1415926535 / 180.;
+    static const double earth_radius = 6371000;
+
+    GeoBound bound;
+    bound.points.reserve(stops_.size());
+    for (const auto stop : stops_) {
+        const double lat = stop->coords.lat * dr;
+        const double lng = stop->coords.lng * dr;
+        bound.points.push_back({
+            earth_radius * std::cos(lat) * std::cos(lng),
+            earth_radius * std::cos(lat) * std::sin(lng),
+            earth_radius * std::sin(lat)
+        });
+    }
+
+    // Ожидание не меняет остановку, поэтому скорость считается только по поездкам.
+    // Поездка нулевой длительности между разными точками делает оценку нулевой
+    double max_speed = 0;
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        const double length = bound.GetChordLength(GetVertexStop(edge.from), GetVertexStop(edge.to));
+        if (length > 0) {
+            max_speed = std::max(max_speed, edge.weight > 0
+                ? length / edge.weight
+                : std::numeric_limits<double>::infinity());
+        }
     }
+    bound.inverse_speed = max_speed > 0 ? 1 / max_speed : 0;
+
+    return bound;
+}
+
+// Участки маршрутов, по которым RAPTOR ищет поездки без пересадок: кольцевой
+// маршрут целиком, некольцевой - отдельно в прямом и в обратном направлении
+std::vector<RaptorRouter::Line> TransportRouter::InitRaptorLines() const {
+    std::vector<RaptorRouter::Line> lines;
+
+    auto add_line = [this, &lines](const Bus* bus, const std::vector<double>& distances,
+                                   size_t start_id, size_t end_id) {
+        RaptorRouter::Line& line = lines.emplace_back();
+        line.bus_name = bus->name;
+        for (size_t i = start_id; i < end_id; ++i) {
+            line.stops.push_back(stop_to_id_[bus->stops[i]]);
+            line.distances.push_back(distances[i]);
+        }
+    };
 
     for (const auto bus : buses_) {
+        const std::vector<double> distances = ComputeDistances(bus);
+
         if (bus->is_roundtrip) {
-            AddToGraph(g, bus, 0, bus->stops.size());
+            add_line(bus, distances, 0, bus->stops.size());
         } else {
             size_t end_stop_idx = bus->stops.size() / 2;
-            AddToGraph(g, bus, 0, end_stop_idx + 1);
-            AddToGraph(g, bus, end_stop_idx, bus->stops.size());
+            add_line(bus, distances, 0, end_stop_idx + 1);
+            add_line(bus, distances, end_stop_idx, bus->stops.size());
         }
     }
 
-    return g;
+    return lines;
 }
 
-}
\ No newline at end of file
+TransportRouter::RouterEngine TransportRouter::InitRouter(std::optional<State>& state) const {
+    switch (settings_.router_type) {
+        case RouterType::DIJKSTRA:
+        case RouterType::A_STAR:
+            return RouterEngine(std::in_place_type<DijkstraRouter>, compact_graph_);
+        case RouterType::RAPTOR:
+            return RouterEngine(
+                std::in_place_type<RaptorRouter>,
+                stops_.size(),
+                InitRaptorLines(),
+                static_cast<double>(settings_.bus_wait_time),
+                settings_.bus_velocity
+            );
+        case RouterType::CONTRACTION_HIERARCHY:
+            if (state && state->contraction_hierarchy) {
+                return RouterEngine(
+                    std::in_place_type<ContractionRouter>, compact_graph_, std::move(*state->contraction_hierarchy)
+                );
+            }
+            return RouterEngine(std::in_place_type<ContractionRouter>, compact_graph_);
+        case RouterType::HUB_LABELS:
+            if (state && state->hub_labels) {
+                return RouterEngine(
+                    std::in_place_type<HubLabelRouter>, compact_graph_, std::move(*state->hub_labels)
+                );
+            }
+            return RouterEngine(std::in_place_type<HubLabelRouter>, compact_graph_);
+        case RouterType::ALL_PAIRS:
+            break;
+    }
+    if (state && state->routes_internal_data) {
+        return RouterEngine(
+            std::in_place_type<AllPairsRouter>, graph_, std::move(*state->routes_internal_data)
+        );
+    }
+    return RouterEngine(std::in_place_type<AllPairsRouter>, graph_, settings_.thread_count);
+}
+
+const TransportRouter::RouteGraph& TransportRouter::GetGraph() const {
+    return graph_;
+}
+
+const std::vector<TransportRouter::EdgeInfo>& TransportRouter::GetEdgesInfo() const {
+    return edges_info_;
+}
+
+const TransportRouter::AllPairsRouter::RoutesInternalData* TransportRouter::GetRoutesInternalData() const {
+    if (const auto* router = std::get_if<AllPairsRouter>(&router_)) {
+        return &router->GetRoutesInternalData();
+    }
+    return nullptr;
+}
+
+void TransportRouter::Update(
+    const std::vector<const Bus*>& buses,
+    const std::vector<std::pair<StopId, StopId>>& road_distances
+) {
+    std::vector<const Bus*> changed_buses;
+    std::unordered_set<const Bus*> is_changed;
+    auto mark_changed = [&changed_buses, &is_changed](const Bus* bus) {
+        if (is_changed.insert(bus).second) {
+            changed_buses.push_back(bus);
+        }
+    };
+
+    for (const auto bus : buses) {
+        mark_changed(bus);
+        if (std::find(buses_.begin(), buses_.end(), bus) == buses_.end()) {
+            buses_.push_back(bus);
+        }
+    }
+
+    // Расстояние между остановками может задаваться в любом направлении
+    if (!road_distances.empty()) {
+        std::set<std::pair<StopId, StopId>> changed_pairs;
+        for (const auto& [from, to] : road_distances) {
+            changed_pairs.insert({from, to});
+            changed_pairs.insert({to, from});
+        }
+        for (const auto bus : buses_) {
+            for (size_t i = 1; i < bus->stops.size(); ++i) {
+                if (changed_pairs.count({bus->stops[i - 1], bus->stops[i]}) != 0) {
+                    mark_changed(bus);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<AllPairsRouter::EdgeUpdate> updates;
+    for (const auto bus : changed_buses) {
+        for (const StopId stop : bus->stops) {
+            if (!FindStopId(stop)) {
+                AddStop(&cat_.GetStop(stop), updates);
+            }
+        }
+    }
+    DropUnusedStops();
+
+    if (settings_.router_type == RouterType::RAPTOR) {
+        router_.emplace<RaptorRouter>(
+            stops_.size(),
+            InitRaptorLines(),
+            static_cast<double>(settings_.bus_wait_time),
+            settings_.bus_velocity
+        );
+        return;
+    }
+
+    for (const auto bus : changed_buses) {
+        UpdateBusEdges(bus, updates);
+    }
+
+    compact_graph_ = InitCompactGraph();
+    geo_bound_ = InitGeoBound();
+    if (auto* router = std::get_if<AllPairsRouter>(&router_)) {
+        router->UpdateEdges(updates);
+    } else if (std::holds_alternative<ContractionRouter>(router_)) {
+        router_.emplace<ContractionRouter>(compact_graph_);
+    } else if (std::holds_alternative<HubLabelRouter>(router_)) {
+        router_.emplace<HubLabelRouter>(compact_graph_);
+    }
+}
+
+// Остановка, через которую больше не идёт ни один автобус, при построении
+// заново не попала бы в граф. Её вершины остаются, но поиск по имени её не
+// находит, а рёбра поездок к ней уже получили бесконечный вес. Если автобус
+// вернётся, остановка добавится заново с новыми вершинами
+void TransportRouter::DropUnusedStops() {
+    std::vector<bool> is_used(stop_to_id_.size(), false);
+    for (const auto bus : buses_) {
+        for (const StopId stop : bus->stops) {
+            if (stop < is_used.size()) {
+                is_used[stop] = true;
+            }
+        }
+    }
+    for (StopId stop = 0; stop < stop_to_id_.size(); ++stop) {
+        if (!is_used[stop]) {
+            stop_to_id_[stop] = NO_STOP;
+        }
+    }
+}
+
+void TransportRouter::AddStop(const Stop* stop, std::vector<AllPairsRouter::EdgeUpdate>& updates) {
+    const size_t id = stops_.size();
+    stops_.push_back(stop);
+    if (stop->id >= stop_to_id_.size()) {
+        stop_to_id_.resize(cat_.GetStopCount(), NO_STOP);
+    }
+    stop_to_id_[stop->id] = id;
+
+    if (settings_.router_type == RouterType::RAPTOR) {
+        return;
+    }
+
+    graph_.AddVertex();
+    if (!HasWaitEdges()) {
+        return;
+    }
+    graph_.AddVertex();
+    const RouteWeight time = MinutesToWeight(settings_.bus_wait_time);
+    updates.push_back({
+        graph_.AddEdge({GetStopVertex(id), GetBoardingVertex(id), time}), AllPairsRouter::INFINITE_WEIGHT
+    });
+    edges_info_.push_back({stop->name, 0, time});
+}
+
+// Рёбра автобуса сопоставляются с прежними по концам и числу пролётов. Совпавшие
+// меняют вес, недостающие добавляются, лишние удаляются. Удалённые рёбра
+// остаются за автобусом и могут вернуться при следующем изменении
+void TransportRouter::UpdateBusEdges(const Bus* bus, std::vector<AllPairsRouter::EdgeUpdate>& updates) {
+    if (!bus_edges_) {
+        bus_edges_ = IndexBusEdges();
+    }
+    std::vector<graph::EdgeId>& edge_ids = (*bus_edges_)[bus->name];
+
+    using EdgeKey = std::tuple<graph::VertexId, graph::VertexId, size_t>;
+    std::map<EdgeKey, std::vector<graph::EdgeId>> old_edges;
+    for (const graph::EdgeId edge_id : edge_ids) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        old_edges[{edge.from, edge.to, edges_info_[edge_id].span_count}].push_back(edge_id);
+    }
+
+    std::vector<graph::EdgeId> new_edge_ids;
+    for (const auto& [edge, span_count, time] : MakeBusEdges(bus)) {
+        auto it = old_edges.find({edge.from, edge.to, span_count});
+        if (it == old_edges.end() || it->second.empty()) {
+            const graph::EdgeId edge_id = graph_.AddEdge(edge);
+            edges_info_.push_back({bus->name, span_count, time});
+            updates.push_back({edge_id, AllPairsRouter::INFINITE_WEIGHT});
+            new_edge_ids.push_back(edge_id);
+            continue;
+        }
+
+        const graph::EdgeId edge_id = it->second.back();
+        it->second.pop_back();
+        const RouteWeight old_weight = graph_.GetEdge(edge_id).weight;
+        if (old_weight != edge.weight) {
+            graph_.SetEdgeWeight(edge_id, edge.weight);
+            edges_info_[edge_id].time = time;
+            updates.push_back({edge_id, old_weight});
+        }
+        new_edge_ids.push_back(edge_id);
+    }
+
+    for (const auto& [key, unused_ids] : old_edges) {
+        for (const graph::EdgeId edge_id : unused_ids) {
+            const RouteWeight old_weight = graph_.GetEdge(edge_id).weight;
+            if (old_weight != AllPairsRouter::INFINITE_WEIGHT) {
+                graph_.SetEdgeWeight(edge_id, AllPairsRouter::INFINITE_WEIGHT);
+                updates.push_back({edge_id, old_weight});
+            }
+            new_edge_ids.push_back(edge_id);
+        }
+    }
+
+    edge_ids = std::move(new_edge_ids);
+}
+
+std::unordered_map<std::string_view, std::vector<graph::EdgeId>> TransportRouter::IndexBusEdges() const {
+    std::unordered_map<std::string_view, std::vector<graph::EdgeId>> bus_edges;
+    for (graph::EdgeId edge_id = 0; edge_id < edges_info_.size(); ++edge_id) {
+        if (edges_info_[edge_id].span_count != 0) {
+            bus_edges[edges_info_[edge_id].name].push_back(edge_id);
+        }
+    }
+    return bus_edges;
+}
+
+const TransportRouter::ContractionRouter::Data* TransportRouter::GetContractionHierarchy() const {
+    if (const auto* router = std::get_if<ContractionRouter>(&router_)) {
+        return &router->GetData();
+    }
+    return nullptr;
+}
+
+const TransportRouter::HubLabelRouter::Data* TransportRouter::GetHubLabels() const {
+    if (const auto* router = std::get_if<HubLabelRouter>(&router_)) {
+        return &router->GetData();
+    }
+    return nullptr;
+}
+
+}
@@ -1,57 +1,201 @@
 #pragma once
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "hub_labels.h"
+#include "raptor_router.h"
+#include "route_weight.h"
 #include "domain.h"
 #include "transport_catalogue.h"
 
+#include <array>
+#include <limits>
+#include <variant>
+
 namespace catalogue::router {
 
 using catalogue::domain::Bus;
 using catalogue::domain::Stop;
+using catalogue::domain::StopId;
 using catalogue::domain::RoutingSettings;
+using catalogue::domain::RouterType;
+using catalogue::domain::GraphModel;
 using catalogue::TransportCatalogue;
 
 
 class TransportRouter {
-private:
+public:
+    // Ребро графа: ожидание на остановке name при span_count == 0, иначе поездка
+    // на автобусе name. В модели с одной вершиной на остановку рёбра ожидания
+    // нет, а вес ребра поездки - ожидание и время поездки time
     struct EdgeInfo {
         std::string_view name;
         size_t span_count;
-        double time;
+        RouteWeight time;
     };
 
-public:
     struct RouteInfo {
-        double total_time;
+        RouteWeight total_time;
         std::vector<EdgeInfo> edges;
     };
 
-    using RouteGraph = graph::DirectedWeightedGraph<double>;
+    // times[i][j] - время в пути от i-й остановки from до j-й остановки to
+    using TimeMatrix = std::vector<std::vector<std::optional<RouteWeight>>>;
+
+    struct ReachedStop {
+        std::string_view name;
+        RouteWeight time;
+    };
+
+    using RouteGraph = graph::DirectedWeightedGraph<RouteWeight>;
+    using CompactRouteGraph = graph::CsrGraph<RouteWeight>;
+    using AllPairsRouter = graph::Router<RouteWeight>;
+    using DijkstraRouter = graph::DijkstraRouter<RouteWeight, CompactRouteGraph>;
+    using ContractionRouter = graph::ContractionHierarchy<RouteWeight, CompactRouteGraph>;
+    using HubLabelRouter = graph::HubLabels<RouteWeight, CompactRouteGraph>;
+
+    // Построенные граф и таблица маршрутов, сохраняемые в базе
+    struct State {
+        RouteGraph graph;
+        std::vector<EdgeInfo> edges_info;
+        std::optional<AllPairsRouter::RoutesInternalData> routes_internal_data;
+        std::optional<ContractionRouter::Data> contraction_hierarchy;
+        std::optional<HubLabelRouter::Data> hub_labels;
+    };
 
     TransportRouter(
         const std::vector<const Stop*>& stops,
         const std::vector<const Bus*>& buses,
         const TransportCatalogue& cat,
-        RoutingSettings settings
+        RoutingSettings settings,
+        std::optional<State> state = std::nullopt
     );
 
-    std::optional<RouteInfo> BuildRoute(
-        const std::string& from, const std::string& to
+    std::optional<RouteInfo> BuildRoute(std::string_view from, std::string_view to) const;
+    // Записывает части маршрута в edges и возвращает время в пути. С таблицей
+    // всех пар память не выделяется, если ёмкости edges хватает
+    std::optional<RouteWeight> BuildRoute(
+        std::string_view from, std::string_view to, std::vector<EdgeInfo>& edges
+    ) const;
+    std::optional<RouteWeight> BuildRoute(StopId from, StopId to, std::vector<EdgeInfo>& edges) const;
+    // Вершина, в которой начинаются и заканчиваются маршруты от остановки name
+    std::optional<graph::VertexId> FindStopVertex(std::string_view name) const;
+    // Один поиск из каждой остановки from, без восстановления маршрутов.
+    // Остановки from распределяются между потоками
+    TimeMatrix BuildTimeMatrix(
+        const std::vector<std::string_view>& from, const std::vector<std::string_view>& to
     ) const;
+    // Остановки, до которых можно добраться из from не более чем за max_time,
+    // в порядке неубывания времени. Поиск ограничен этой областью
+    std::optional<std::vector<ReachedStop>> BuildIsochrone(
+        std::string_view from, RouteWeight max_time
+    ) const;
+    std::optional<std::vector<ReachedStop>> BuildIsochrone(StopId from, RouteWeight max_time) const;
+
+    const RouteGraph& GetGraph() const;
+    const std::vector<EdgeInfo>& GetEdgesInfo() const;
+    const AllPairsRouter::RoutesInternalData* GetRoutesInternalData() const;
+    const ContractionRouter::Data* GetContractionHierarchy() const;
+    const HubLabelRouter::Data* GetHubLabels() const;
+
+    // Учитывает изменения справочника: добавленные или изменённые автобусы buses
+    // и новые расстояния между парами остановок road_distances. Меняются только
+    // затронутые рёбра графа, таблица маршрутов исправляется частично.
+    // Иерархия сжатия, метки хабов и участки RAPTOR строятся заново
+    void Update(
+        const std::vector<const Bus*>& buses,
+        const std::vector<std::pair<StopId, StopId>>& road_distances
+    );
 
 private:
     std::vector<EdgeInfo> edges_info_;
     std::vector<graph::EdgeId> edges_;
 
-    const std::vector<const Stop*>& stops_;
-    const std::vector<const Bus*>& buses_;
+    std::vector<const Stop*> stops_;
+    std::vector<const Bus*> buses_;
     const TransportCatalogue& cat_;
     RoutingSettings settings_;
+    // Номер в stops_ по номеру остановки в справочнике, NO_STOP - остановки нет.
+    // Вершины остановки - id * 2 (прибытие) и id * 2 + 1 (посадка), а в модели
+    // с одной вершиной - id. Имена ищутся в справочнике
+    std::vector<size_t> stop_to_id_;
     RouteGraph graph_;
-    const graph::Router<double> router_;
+    // Компактная копия графа для маршрутизаторов, обходящих его при каждом запросе
+    CompactRouteGraph compact_graph_;
+    // Номера рёбер поездок каждого автобуса, строится при первом изменении
+    std::optional<std::unordered_map<std::string_view, std::vector<graph::EdgeId>>> bus_edges_;
+
+    // Нижняя оценка времени в пути для A*: длина хорды между остановками,
+    // делённая на наибольшую скорость вдоль рёбер графа. Хорда не длиннее
+    // дуги и удовлетворяет неравенству треугольника, поэтому оценка допустима
+    struct GeoBound {
+        // Точки остановок в декартовых координатах, в метрах
+        std::vector<std::array<double, 3>> points;
+        double inverse_speed = 0;
+
+        double GetChordLength(size_t from_id, size_t to_id) const;
+    };
+    GeoBound geo_bound_;
+    // Ограниченный поиск по графу для изохрон, не зависящий от выбранного маршрутизатора
+    const graph::DijkstraRouter<RouteWeight, RouteGraph> reachability_router_;
+
+    using RouterEngine = std::variant<
+        AllPairsRouter,
+        DijkstraRouter,
+        RaptorRouter,
+        ContractionRouter,
+        HubLabelRouter
+    >;
+    RouterEngine router_;
+
+    struct BusEdge {
+        graph::Edge<RouteWeight> edge;
+        size_t span_count;
+        // Время поездки без ожидания
+        RouteWeight time;
+    };
+
+    bool HasWaitEdges() const;
+    // Вершина, в которой начинаются и заканчиваются маршруты от остановки
+    graph::VertexId GetStopVertex(size_t stop_id) const;
+    graph::VertexId GetBoardingVertex(size_t stop_id) const;
+    size_t GetVertexStop(graph::VertexId vertex) const;
+    // Добавляет в edges части маршрута, соответствующие ребру графа
+    void AppendEdgeInfo(graph::EdgeId edge_id, std::vector<EdgeInfo>& edges) const;
+
+    // Номер остановки в stops_, nullopt - остановки нет в графе
+    std::optional<size_t> FindStopId(std::string_view name) const;
+    std::optional<size_t> FindStopId(StopId stop) const;
+    static constexpr size_t NO_STOP = std::numeric_limits<size_t>::max();
 
+    std::vector<size_t> IndexStops() const;
+    std::vector<double> ComputeDistances(const Bus* bus) const;
+    std::vector<BusEdge> MakeBusEdges(const Bus* bus) const;
     RouteGraph InitGraph();
-    void AddToGraph(RouteGraph& g, const Bus* bus, size_t start_id, size_t end_id);
+    RouteGraph SortEdgesBySource(const RouteGraph& g);
+    CompactRouteGraph InitCompactGraph() const;
+    GeoBound InitGeoBound() const;
+    std::vector<RaptorRouter::Line> InitRaptorLines() const;
+    RouterEngine InitRouter(std::optional<State>& state) const;
+    std::optional<RouteWeight> BuildRaptorRoute(
+        const RaptorRouter& router, size_t from_id, size_t to_id, std::vector<EdgeInfo>& edges
+    ) const;
+    std::vector<RouteWeight> ComputeTimes(size_t from_id) const;
+    std::optional<DijkstraRouter::RouteInfo> BuildGeoRoute(
+        const DijkstraRouter& router, size_t from_id, size_t to_id
+    ) const;
+    void AddBusEdges(
+        std::vector<BusEdge>& edges,
+        const Bus* bus,
+        const std::vector<double>& distances,
+        size_t start_id,
+        size_t end_id
+    ) const;
+    void DropUnusedStops();
+    void AddStop(const Stop* stop, std::vector<AllPairsRouter::EdgeUpdate>& updates);
+    void UpdateBusEdges(const Bus* bus, std::vector<AllPairsRouter::EdgeUpdate>& updates);
+    std::unordered_map<std::string_view, std::vector<graph::EdgeId>> IndexBusEdges() const;
 };
 
 }
\ No newline at end of file